@@ -0,0 +1,512 @@
+// Benchmarks for the hot path of every game, in one executable.
+//
+// Each game is a single .cpp file with its own main(), so instead of linking them we include
+// them here, each in its own namespace and with main() renamed. Everything the games write to
+// the terminal goes to /dev/null while the benchmarks run, and the results are printed as JSON.
+//
+// Build: g++ -std=c++17 -O2 -pthread bench.cpp -o bench $(sdl2-config --cflags --libs)
+// Usage: ./bench [--baseline previous.json] [--tolerance 0.25] > results.json
+//
+// With --baseline, every result is compared with the same benchmark in an earlier results file,
+// and the program exits with status 1 if any of them got slower by more than the tolerance, or if
+// a benchmark in the baseline was not run.
+// Two runs of the same binary on a busy machine can differ by 15-20%, hence the 25% default;
+// on a quiet, dedicated machine a tighter tolerance works.
+
+// Include everything the games include up front, so their own includes are no-ops
+// inside the namespaces below.
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cctype>
+#include <climits>
+#include <deque>
+#include <memory>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdio.h>
+#include <fcntl.h>
+#include <sys/select.h>
+#include <termios.h>
+#include <unistd.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include <SDL2/SDL.h>
+
+#include "tick-profiler.h"
+
+#define main snek_main
+namespace snek {
+#include "snek.cpp"
+}
+#undef main
+
+// The snek games define the same terminal escape macros, and cops-n-robbers reuses
+// some of their names for variables.
+#undef CLEAR_SCREEN
+#undef CURSOR_HOME
+#undef RED_TEXT
+#undef GREEN_TEXT
+#undef RESET_COLOR
+
+#define main snek2_main
+namespace snek2 {
+#include "snek2.cpp"
+}
+#undef main
+
+#undef CLEAR_SCREEN
+#undef CURSOR_HOME
+#undef RED_TEXT
+#undef GREEN_TEXT
+#undef RESET_COLOR
+
+#define main cops_main
+namespace cops {
+#include "cops-n-robbers.cpp"
+}
+#undef main
+
+#define main chiptune_main
+namespace chiptune {
+#include "chiptune-piano.cpp"
+}
+#undef main
+
+#define main imagegen_main
+namespace imagegen {
+#include "imagegen.cpp"
+}
+#undef main
+
+// Each benchmark is timed in several rounds of at least this long, and the median round counts.
+// A single short round is easily thrown off by the scheduler or a frequency change.
+const double MIN_ROUND_SECONDS = 0.2;
+const int ROUNDS = 7;
+
+// One measured result. All values are rates, so higher is always better.
+struct BenchResult {
+    std::string name;
+    double value;
+    std::string unit;
+};
+
+// Results are written here so the compiler cannot optimise the measured work away.
+volatile long long g_sink = 0;
+
+// Median of a list of per-round rates.
+double medianRate(std::vector<double> rates) {
+    std::sort(rates.begin(), rates.end());
+    return rates[rates.size() / 2];
+}
+
+// Run fn repeatedly and return how many work units per second it gets through,
+// where one call to fn does unitsPerCall units of work.
+double measureRate(const std::function<void()>& fn, double unitsPerCall) {
+    fn(); // Warm up caches and lazy initialisation.
+
+    std::vector<double> rates;
+    for (int round = 0; round < ROUNDS; ++round) {
+        long long calls = 0;
+        auto start = std::chrono::steady_clock::now();
+        std::chrono::duration<double> elapsed(0);
+        while (elapsed.count() < MIN_ROUND_SECONDS) {
+            for (int i = 0; i < 16; ++i) {
+                fn();
+            }
+            calls += 16;
+            elapsed = std::chrono::steady_clock::now() - start;
+        }
+        rates.push_back(calls * unitsPerCall / elapsed.count());
+    }
+    return medianRate(rates);
+}
+
+// Like measureRate(), for work whose speed depends on state it changes, such as a game that
+// keeps running. Every round starts with an untimed reset() and then makes exactly
+// callsPerRound calls, so every run measures the same work whatever the previous rounds did.
+double measureRateFromReset(const std::function<void()>& reset, const std::function<void()>& fn,
+                            int callsPerRound, double unitsPerCall) {
+    std::vector<double> rates;
+    for (int round = -1; round < ROUNDS; ++round) { // Round -1 is the warm-up.
+        reset();
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < callsPerRound; ++i) {
+            fn();
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        if (round >= 0) {
+            rates.push_back(callsPerRound * unitsPerCall / elapsed.count());
+        }
+    }
+    return medianRate(rates);
+}
+
+// A stream buffer that throws everything away but counts the bytes, so we can measure
+// how fast imagegen formats pixels without measuring the disk.
+class CountingNullBuffer : public std::streambuf {
+public:
+    long long bytes = 0;
+
+protected:
+    int overflow(int c) override {
+        bytes++;
+        return c == EOF ? 0 : c;
+    }
+
+    std::streamsize xsputn(const char*, std::streamsize count) override {
+        bytes += count;
+        return count;
+    }
+};
+
+// The snek games' board from snek.cpp's main(), with food in fixed places so runs compare.
+std::vector<std::vector<char>> makeSnekWorld(char foodChar) {
+    std::vector<std::vector<char>> world(10, std::vector<char>(20, ' '));
+    world[3][5] = foodChar;
+    world[8][15] = foodChar;
+    world[2][10] = foodChar;
+    world[6][3] = foodChar;
+    world[7][18] = foodChar;
+    return world;
+}
+
+void benchSnek(std::vector<BenchResult>& results) {
+    std::vector<std::vector<char>> world = makeSnekWorld(snek::FOOD_CHAR);
+    snek::Point snakePos = {1, 1};
+
+    results.push_back({"snek.findNearestFood+getNextMove", measureRate([&] {
+        snek::Point food = snek::findNearestFood(world, snakePos);
+        snek::Point next = snek::getNextMove(snakePos, food);
+        g_sink = g_sink + next.x + next.y;
+    }, 1), "calls/s"});
+
+    results.push_back({"snek.drawWorld", measureRate([&] {
+        snek::drawWorld(world, snakePos);
+    }, 1), "frames/s"});
+}
+
+void benchSnek2(std::vector<BenchResult>& results) {
+    std::vector<std::vector<char>> world = makeSnekWorld(snek2::FOOD_CHAR);
+    std::vector<snek2::Point> snakeBody = {{5, 5}, {5, 6}, {5, 7}, {6, 7}, {7, 7}};
+
+    results.push_back({"snek2.findNearestFood+getNextMove", measureRate([&] {
+        snek2::Point food = snek2::findNearestFood(world, snakeBody[0]);
+        snek2::Point next = snek2::getNextMove(snakeBody[0], food);
+        g_sink = g_sink + next.x + next.y;
+    }, 1), "calls/s"});
+
+    results.push_back({"snek2.drawWorld", measureRate([&] {
+        snek2::drawWorld(world, snakeBody);
+    }, 1), "frames/s"});
+
+    // One planning thread, so the number does not depend on how busy the machine is. Every
+    // round plays the same 1000 ticks from the same seed.
+    snek2::Arena arena;
+    snek2::WorkerPool pool(1);
+    results.push_back({"snek2.arena_tick_1000_snakes", measureRateFromReset([&] {
+        arena = snek2::createArena(1000, 12345);
+    }, [&] {
+        snek2::stepArena(arena, pool);
+    }, 1000, 1), "ticks/s"});
+}
+
+void benchCops(std::vector<BenchResult>& results) {
+    const std::vector<std::string> startMap = cops::gameMap;
+
+    // moveCop() walks through walls and erases what it passes over,
+    // so put everything back every time the cop catches the robber.
+    auto resetBoard = [&] {
+        cops::gameMap = startMap;
+        cops::robberX = 1;
+        cops::robberY = 1;
+        cops::copX = 33;
+        cops::copY = 17;
+        cops::gameOver = false;
+        cops::gameMap[cops::robberY][cops::robberX] = cops::ROBBER;
+        cops::gameMap[cops::copY][cops::copX] = cops::COP;
+    };
+
+    resetBoard();
+    results.push_back({"cops.moveCop", measureRate([&] {
+        if (cops::gameOver) {
+            resetBoard();
+        }
+        cops::moveCop();
+    }, 1), "moves/s"});
+
+    resetBoard();
+    results.push_back({"cops.drawMap", measureRate([] {
+        cops::drawMap();
+    }, 1), "frames/s"});
+}
+
+// Silence every voice and switch all effects off.
+void resetChiptune() {
+    for (chiptune::Voice& voice : chiptune::g_voices) {
+        voice = chiptune::Voice();
+    }
+    chiptune::g_vibrato = false;
+    chiptune::g_arpeggio = false;
+    chiptune::g_slide = false;
+    chiptune::g_lastNote = -1.0;
+
+    SDL_AudioSpec spec;
+    SDL_zero(spec);
+    spec.freq = chiptune::SAMPLE_RATE;
+    spec.channels = chiptune::CHANNELS;
+    spec.format = AUDIO_S16SYS;
+    chiptune::configureOutput(spec);
+}
+
+void benchChiptune(std::vector<BenchResult>& results) {
+    const int bufferSamples = chiptune::SAMPLES_PER_BUFFER;
+    std::vector<Sint16> buffer(bufferSamples);
+    auto callback = [&] {
+        chiptune::audio_callback(nullptr, reinterpret_cast<Uint8*>(buffer.data()),
+                                 static_cast<int>(buffer.size() * sizeof(Sint16)));
+        g_sink = g_sink + buffer[bufferSamples - 1];
+    };
+
+    resetChiptune();
+    chiptune::noteOn(SDLK_h, 69);
+    results.push_back({"chiptune.audio_callback", measureRate(callback, bufferSamples), "samples/s"});
+
+    // Voices x effects, in multiples of real time: 1/x is the share of the callback's
+    // time budget (one buffer's worth of playback) that generating the buffer takes.
+    struct EffectSet {
+        const char* name;
+        bool vibrato;
+        bool arpeggio;
+        bool slide;
+    };
+    const EffectSet effectSets[] = {
+        {"none", false, false, false},
+        {"vibrato", true, false, false},
+        {"arpeggio", false, true, false},
+        {"slide", false, false, true},
+        {"all", true, true, true},
+    };
+    const int voiceCounts[] = {1, 4, chiptune::MAX_VOICES};
+
+    for (int voices : voiceCounts) {
+        for (const EffectSet& effects : effectSets) {
+            resetChiptune();
+            chiptune::g_vibrato = effects.vibrato;
+            chiptune::g_arpeggio = effects.arpeggio;
+            chiptune::g_slide = effects.slide;
+            for (int v = 0; v < voices; ++v) {
+                chiptune::noteOn(1000 + v, 48 + 3 * v);
+            }
+
+            double samplesPerSecond = measureRate(callback, bufferSamples);
+            results.push_back({"chiptune.voices_" + std::to_string(voices) + ".effects_" + effects.name,
+                               samplesPerSecond / chiptune::SAMPLE_RATE, "x realtime"});
+        }
+    }
+
+    // The cost of letting SDL convert, for a typical float32 stereo 48 kHz device: before, we
+    // generated s16 mono at 44.1 kHz and SDL converted every buffer; now we generate the
+    // device's own format. Both are in multiples of real time.
+    resetChiptune();
+    chiptune::noteOn(SDLK_h, 69);
+    SDL_AudioCVT cvt;
+    if (SDL_BuildAudioCVT(&cvt, AUDIO_S16SYS, 1, chiptune::SAMPLE_RATE, AUDIO_F32SYS, 2, 48000) > 0) {
+        const int sourceBytes = bufferSamples * static_cast<int>(sizeof(Sint16));
+        std::vector<Uint8> cvtBuffer(static_cast<size_t>(sourceBytes) * cvt.len_mult);
+        cvt.buf = cvtBuffer.data();
+        results.push_back({"chiptune.s16_mono_44k_sdl_converted_to_f32_stereo_48k", measureRate([&] {
+            chiptune::audio_callback(nullptr, cvt.buf, sourceBytes);
+            cvt.len = sourceBytes;
+            SDL_ConvertAudio(&cvt);
+            g_sink = g_sink + cvt.buf[0];
+        }, static_cast<double>(bufferSamples) / chiptune::SAMPLE_RATE), "x realtime"});
+    }
+
+    SDL_AudioSpec device;
+    SDL_zero(device);
+    device.freq = 48000;
+    device.channels = 2;
+    device.format = AUDIO_F32SYS;
+    chiptune::configureOutput(device);
+    std::vector<float> floatBuffer(bufferSamples * 2);
+    results.push_back({"chiptune.native_f32_stereo_48k", measureRate([&] {
+        chiptune::audio_callback(nullptr, reinterpret_cast<Uint8*>(floatBuffer.data()),
+                                 static_cast<int>(floatBuffer.size() * sizeof(float)));
+        g_sink = g_sink + static_cast<long long>(floatBuffer[0] * 1000.0f);
+    }, static_cast<double>(bufferSamples) / device.freq), "x realtime"});
+
+    resetChiptune();
+}
+
+void benchImagegen(std::vector<BenchResult>& results) {
+    CountingNullBuffer nullBuffer;
+    std::ostream nullStream(&nullBuffer);
+
+    // Count the bytes of one image, then measure how many of those bytes we write per second.
+    imagegen::writeImage(nullStream, 512, 512, 255, 128, 0);
+    double bytesPerImage = static_cast<double>(nullBuffer.bytes);
+
+    double bytesPerSecond = measureRate([&] {
+        imagegen::writeImage(nullStream, 512, 512, 255, 128, 0);
+    }, bytesPerImage);
+    results.push_back({"imagegen.writeImage", bytesPerSecond / 1e6, "MB/s"});
+
+    // The streaming pipeline's operations, in MB/s of 8-bit RGB input, on a band of 1080p rows.
+    const int width = 1920;
+    const int rows = 64;
+    const double bandBytes = static_cast<double>(width) * 3 * rows;
+    std::vector<imagegen::Row> band(rows, imagegen::Row(width * 3));
+    for (int y = 0; y < rows; ++y) {
+        for (int i = 0; i < width * 3; ++i) {
+            band[y][i] = static_cast<float>((i * 7 + y * 13) % 256);
+        }
+    }
+
+    auto benchStage = [&](const char* name, const char* operation) {
+        std::unique_ptr<imagegen::Stage> stage = imagegen::parseStage(operation);
+        imagegen::RowQueue out(rows * 4);
+        double rate = measureRate([&] {
+            int w = width;
+            int h = rows;
+            stage->configure(w, h);
+            for (int y = 0; y < rows; ++y) {
+                imagegen::Row row = band[y];
+                stage->process(row, out);
+            }
+            stage->finish(out);
+
+            imagegen::Row row;
+            for (int y = 0; y < h; ++y) {
+                out.pop(row);
+            }
+            g_sink = g_sink + static_cast<long long>(row[0]);
+        }, bandBytes);
+        results.push_back({name, rate / 1e6, "MB/s"});
+    };
+    benchStage("imagegen.pipeline_blur", "blur:2");
+    benchStage("imagegen.pipeline_resize", "resize:1280x43");
+    benchStage("imagegen.pipeline_tint", "tint:FF8000:0.5");
+    benchStage("imagegen.pipeline_crop", "crop:100,0,1280,64");
+}
+
+void writeResultsJson(std::ostream& out, const std::vector<BenchResult>& results) {
+    // One benchmark per line, which keeps the file easy to diff and to read back in.
+    out << "{\n  \"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        char value[32];
+        std::snprintf(value, sizeof(value), "%.3f", results[i].value);
+        out << "    {\"name\": \"" << results[i].name << "\", \"value\": " << value
+            << ", \"unit\": \"" << results[i].unit << "\"}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+}
+
+// Read the results back from a file written by writeResultsJson().
+std::vector<BenchResult> readResultsJson(const std::string& path) {
+    std::vector<BenchResult> results;
+    std::ifstream in(path);
+    std::string line;
+    while (std::getline(in, line)) {
+        size_t name = line.find("\"name\": \"");
+        size_t value = line.find("\"value\": ");
+        if (name == std::string::npos || value == std::string::npos) {
+            continue;
+        }
+        name += 9;
+        BenchResult result;
+        result.name = line.substr(name, line.find('"', name) - name);
+        result.value = std::strtod(line.c_str() + value + 9, nullptr);
+        results.push_back(result);
+    }
+    return results;
+}
+
+int main(int argc, char* argv[]) {
+    std::string baselinePath;
+    double tolerance = 0.25;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--baseline" && i + 1 < argc) {
+            baselinePath = argv[++i];
+        } else if (arg == "--tolerance" && i + 1 < argc) {
+            tolerance = std::stod(argv[++i]);
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--baseline previous.json] [--tolerance 0.25]" << std::endl;
+            return 1;
+        }
+    }
+
+    // Send everything the games print to /dev/null while they run.
+    std::fflush(stdout);
+    int savedStdout = dup(STDOUT_FILENO);
+    int nullFd = open("/dev/null", O_WRONLY);
+    dup2(nullFd, STDOUT_FILENO);
+    close(nullFd);
+
+    std::vector<BenchResult> results;
+    benchSnek(results);
+    benchSnek2(results);
+    benchCops(results);
+    benchChiptune(results);
+    benchImagegen(results);
+
+    std::cout << std::flush;
+    std::fflush(stdout);
+    dup2(savedStdout, STDOUT_FILENO);
+    close(savedStdout);
+
+    writeResultsJson(std::cout, results);
+
+    if (baselinePath.empty()) {
+        return 0;
+    }
+
+    std::vector<BenchResult> baseline = readResultsJson(baselinePath);
+    if (baseline.empty()) {
+        std::cerr << "No results found in " << baselinePath << std::endl;
+        return 1;
+    }
+
+    // A benchmark that was renamed or dropped has nothing to compare with, which must not pass silently.
+    bool regressed = false;
+    for (const BenchResult& old : baseline) {
+        bool found = false;
+        for (const BenchResult& result : results) {
+            found = found || result.name == old.name;
+        }
+        if (!found) {
+            regressed = true;
+            std::fprintf(stderr, "MISSING    %s is in %s but was not run\n", old.name.c_str(), baselinePath.c_str());
+        }
+    }
+    for (const BenchResult& result : results) {
+        for (const BenchResult& old : baseline) {
+            if (old.name != result.name || old.value <= 0.0) {
+                continue;
+            }
+            double change = result.value / old.value - 1.0;
+            if (change < -tolerance) {
+                regressed = true;
+                std::fprintf(stderr, "REGRESSION %-36s %12.1f -> %12.1f %s (%+.1f%%)\n", result.name.c_str(),
+                             old.value, result.value, result.unit.c_str(), change * 100.0);
+            }
+        }
+    }
+    return regressed ? 1 : 0;
+}
@@ -1,55 +1,535 @@
 #include <iostream>
 #include <vector>
 #include <cmath>
+#include <algorithm>
+#include <string>
+#include <atomic>
+#include <cstdio>
 #include <SDL2/SDL.h>
 
-// Define our audio parameters
+// Define our audio parameters. These are what we ask for; the device may pick
+// something else, and we then generate in whatever it picked.
 const int SAMPLE_RATE = 44100;
 const int SAMPLES_PER_BUFFER = 512;
 const int CHANNELS = 1; // Mono
-const double VOLUME = 0.5;
+const double VOLUME = 0.9; // Peak of the mix with every voice at full level, so it never clips
+const double STEREO_WIDTH = 0.7; // How far low and high notes are panned apart, 0..1
 
-// Global state for audio generation
-double g_frequency = 0.0;
-double g_phase = 0.0;
+// The format the audio device actually runs at, filled in when it is opened.
+int g_sampleRate = SAMPLE_RATE;
+int g_channels = CHANNELS;
+SDL_AudioFormat g_format = AUDIO_S16SYS;
 
-// This callback function is called by SDL whenever it needs more audio data
-void audio_callback(void* userdata, Uint8* stream, int len) {
-    // Cast the stream to a signed 16-bit integer array
-    Sint16* audio_stream = reinterpret_cast<Sint16*>(stream);
-    int num_samples = len / sizeof(Sint16);
-
-    for (int i = 0; i < num_samples; ++i) {
-        if (g_frequency > 0.0) {
-            // Calculate the current sample value for a square wave
-            Sint16 sample = (std::sin(g_phase * 2.0 * M_PI) >= 0.0) ? 
-                             static_cast<Sint16>(32767.0 * VOLUME) : 
-                             static_cast<Sint16>(-32767.0 * VOLUME);
-            
-            // Increment the phase for the next sample
-            g_phase += g_frequency / SAMPLE_RATE;
-        
-            // Wrap the phase to prevent it from growing too large
-            if (g_phase >= 1.0) {
-                g_phase -= 1.0;
-            }
-            
-            audio_stream[i] = sample;
-        } else {
-            // If frequency is 0, play silence
-            audio_stream[i] = 0;
-        }
-    }
-}
+// Sound design: every note is shaped by an ADSR envelope, and the effects below can be
+// switched on from the keyboard. Times are in seconds, pitches in semitones.
+const int MAX_VOICES = 8;
+const int CONTROL_BLOCK = 64;           // Samples per control-rate update.
+const double ATTACK_TIME = 0.01;
+const double DECAY_TIME = 0.15;
+const double SUSTAIN_LEVEL = 0.6;
+const double RELEASE_TIME = 0.25;
+const double VIBRATO_RATE = 5.5;        // Hz
+const double VIBRATO_DEPTH = 0.3;       // Semitones either side of the note
+const double SLIDE_SPEED = 60.0;        // Semitones per second
+const double ARPEGGIO_RATE = 50.0;      // Steps per second, like a tracker running at 50 Hz
+const int ARPEGGIO_STEPS[] = {0, 4, 7}; // Major chord
+const int ARPEGGIO_LENGTH = 3;
+const double VOICE_GAIN = VOLUME / MAX_VOICES; // Each voice's share of the mix
+
+enum EnvelopeStage { ENVELOPE_OFF, ENVELOPE_ATTACK, ENVELOPE_DECAY, ENVELOPE_SUSTAIN, ENVELOPE_RELEASE };
+
+// One square-wave voice. Pitch and loudness are worked out once per control block;
+// gain and increment are the values at the current sample, which the audio loop moves
+// in a straight line towards the next block's values.
+struct Voice {
+    int key;              // Key holding the note down, or 0 once released.
+    double note;          // The note being played, as a MIDI note number.
+    double slideNote;     // Where the pitch is right now while sliding towards note.
+    EnvelopeStage stage;
+    double level;         // Envelope level, 0..1.
+    double vibratoPhase;  // 0..1
+    double arpeggioTime;  // Seconds since the note started.
+    int arpeggioStep;
+    unsigned age;         // When the note started, for voice stealing.
+    float panLeft;        // Equal-power pan gains, used when the device is stereo.
+    float panRight;
+    float phase;          // Oscillator phase, 0..1.
+    float increment;      // Phase step per sample.
+    float gain;
+};
+
+// Global state for audio generation. The main thread only changes it with the audio device locked.
+Voice g_voices[MAX_VOICES] = {};
+bool g_vibrato = false;
+bool g_arpeggio = false;
+bool g_slide = false;
+double g_lastNote = -1.0;
+unsigned g_noteCounter = 0;
 
 // Function to get the frequency of a musical note
-double noteToFrequency(int note) {
+double noteToFrequency(double note) {
     // A4 is 440 Hz (MIDI note 69)
     double a4_freq = 440.0;
     double a4_midi_note = 69.0;
     return a4_freq * std::pow(2.0, (note - a4_midi_note) / 12.0);
 }
 
+// Start a note on a free voice, or steal the quietest / oldest one if all are busy.
+void noteOn(int key, int note) {
+    Voice* voice = nullptr;
+    for (Voice& v : g_voices) {
+        if (v.stage != ENVELOPE_OFF && v.key == key) {
+            voice = &v; // Retrigger the same key.
+            break;
+        }
+    }
+    for (Voice& v : g_voices) {
+        if (voice == nullptr && v.stage == ENVELOPE_OFF) {
+            voice = &v;
+        }
+    }
+    if (voice == nullptr) {
+        voice = &g_voices[0];
+        for (Voice& v : g_voices) {
+            bool quieter = v.stage == ENVELOPE_RELEASE &&
+                           (voice->stage != ENVELOPE_RELEASE || v.level < voice->level);
+            bool older = v.stage != ENVELOPE_RELEASE && voice->stage != ENVELOPE_RELEASE && v.age < voice->age;
+            if (quieter || older) {
+                voice = &v;
+            }
+        }
+    }
+
+    bool wasSilent = voice->stage == ENVELOPE_OFF;
+    voice->key = key;
+    voice->note = note;
+    voice->slideNote = (g_slide && g_lastNote >= 0.0) ? g_lastNote : note;
+    voice->stage = ENVELOPE_ATTACK;
+    voice->vibratoPhase = 0.0;
+    voice->arpeggioTime = 0.0;
+    voice->arpeggioStep = 0;
+    voice->age = g_noteCounter++;
+
+    // Spread the keyboard across the stereo field, low notes to the left.
+    double pan = std::max(-1.0, std::min(1.0, (note - 66.0) / 6.0)) * STEREO_WIDTH;
+    double panAngle = (pan + 1.0) * M_PI / 4.0;
+    voice->panLeft = static_cast<float>(std::cos(panAngle));
+    voice->panRight = static_cast<float>(std::sin(panAngle));
+    if (wasSilent) {
+        // A stolen voice keeps its level and phase, so the takeover does not click.
+        voice->level = 0.0;
+        voice->phase = 0.0f;
+        voice->gain = 0.0f;
+        voice->increment = static_cast<float>(noteToFrequency(voice->slideNote) / g_sampleRate);
+    }
+    g_lastNote = note;
+}
+
+// Release the note held by a key; it fades out over RELEASE_TIME.
+void noteOff(int key) {
+    for (Voice& v : g_voices) {
+        if (v.key == key && v.stage != ENVELOPE_OFF) {
+            v.stage = ENVELOPE_RELEASE;
+            v.key = 0;
+        }
+    }
+}
+
+// Advance a voice's envelope and effects by one control block of the given length, and
+// return its pitch at the end of the block. This is the only place with pow/sin calls,
+// so their cost is shared by all the samples of the block.
+double updateVoiceControl(Voice& voice, int samples) {
+    double dt = static_cast<double>(samples) / g_sampleRate;
+
+    switch (voice.stage) {
+        case ENVELOPE_ATTACK:
+            voice.level += dt / ATTACK_TIME;
+            if (voice.level >= 1.0) {
+                voice.level = 1.0;
+                voice.stage = ENVELOPE_DECAY;
+            }
+            break;
+        case ENVELOPE_DECAY:
+            voice.level -= dt * (1.0 - SUSTAIN_LEVEL) / DECAY_TIME;
+            if (voice.level <= SUSTAIN_LEVEL) {
+                voice.level = SUSTAIN_LEVEL;
+                voice.stage = ENVELOPE_SUSTAIN;
+            }
+            break;
+        case ENVELOPE_RELEASE:
+            voice.level -= dt * SUSTAIN_LEVEL / RELEASE_TIME;
+            if (voice.level < 0.0) {
+                voice.level = 0.0;
+            }
+            break;
+        default:
+            break;
+    }
+
+    // Pitch slide (portamento) from the previous note.
+    if (voice.slideNote < voice.note) {
+        voice.slideNote = std::min(voice.note, voice.slideNote + SLIDE_SPEED * dt);
+    } else if (voice.slideNote > voice.note) {
+        voice.slideNote = std::max(voice.note, voice.slideNote - SLIDE_SPEED * dt);
+    }
+    double pitch = voice.slideNote;
+
+    if (g_arpeggio) {
+        voice.arpeggioTime += dt;
+        voice.arpeggioStep = static_cast<int>(voice.arpeggioTime * ARPEGGIO_RATE) % ARPEGGIO_LENGTH;
+        pitch += ARPEGGIO_STEPS[voice.arpeggioStep];
+    }
+
+    if (g_vibrato) {
+        voice.vibratoPhase += VIBRATO_RATE * dt;
+        voice.vibratoPhase -= std::floor(voice.vibratoPhase);
+        pitch += VIBRATO_DEPTH * std::sin(voice.vibratoPhase * 2.0 * M_PI);
+    }
+
+    return pitch;
+}
+
+// Add one control block of a voice to the mix. Gain and phase increment are ramped
+// linearly from the last block's values, so apart from the ramps each sample costs
+// one phase step and one add per channel. Pass right as nullptr for a mono mix in left.
+void renderVoice(Voice& voice, float* left, float* right, int samples) {
+    int previousStep = voice.arpeggioStep;
+    double pitch = updateVoiceControl(voice, samples);
+
+    float targetGain = static_cast<float>(voice.level * VOICE_GAIN);
+    float targetIncrement = static_cast<float>(noteToFrequency(pitch) / g_sampleRate);
+    if (voice.arpeggioStep != previousStep) {
+        // Arpeggio steps are meant to be sharp jumps, not glides.
+        voice.increment = targetIncrement;
+    }
+
+    float gain = voice.gain;
+    float increment = voice.increment;
+    float gainStep = (targetGain - gain) / samples;
+    float incrementStep = (targetIncrement - increment) / samples;
+    float phase = voice.phase;
+
+    if (right == nullptr) {
+        for (int i = 0; i < samples; ++i) {
+            // A square wave is high for the first half of each period.
+            left[i] += (phase < 0.5f) ? gain : -gain;
+            phase += increment;
+            phase -= (phase >= 1.0f) ? 1.0f : 0.0f;
+            gain += gainStep;
+            increment += incrementStep;
+        }
+    } else {
+        float panLeft = voice.panLeft;
+        float panRight = voice.panRight;
+        for (int i = 0; i < samples; ++i) {
+            float value = (phase < 0.5f) ? gain : -gain;
+            left[i] += value * panLeft;
+            right[i] += value * panRight;
+            phase += increment;
+            phase -= (phase >= 1.0f) ? 1.0f : 0.0f;
+            gain += gainStep;
+            increment += incrementStep;
+        }
+    }
+
+    voice.phase = phase;
+    voice.gain = targetGain;
+    voice.increment = targetIncrement;
+    if (voice.stage == ENVELOPE_RELEASE && voice.level <= 0.0) {
+        voice.stage = ENVELOPE_OFF;
+    }
+}
+
+// Check whether we can write a sample format ourselves, so SDL does not need to convert.
+bool canGenerate(SDL_AudioFormat format) {
+    return format == AUDIO_S16SYS || format == AUDIO_F32SYS || format == AUDIO_S32SYS ||
+           format == AUDIO_U8 || format == AUDIO_S8;
+}
+
+// Function to get a short name for a sample format, for logging
+std::string formatName(SDL_AudioFormat format) {
+    switch (format) {
+        case AUDIO_S16SYS: return "s16";
+        case AUDIO_F32SYS: return "float32";
+        case AUDIO_S32SYS: return "s32";
+        case AUDIO_U8: return "u8";
+        case AUDIO_S8: return "s8";
+        default: {
+            char name[16];
+            std::snprintf(name, sizeof(name), "format 0x%04x", static_cast<unsigned>(format));
+            return name;
+        }
+    }
+}
+
+// Use the format the device was opened with for all generated audio.
+void configureOutput(const SDL_AudioSpec& spec) {
+    g_sampleRate = spec.freq;
+    g_channels = spec.channels;
+    g_format = spec.format;
+}
+
+// Convert a block of the mix to the device's sample type and interleave it. The first two
+// channels get left and right, any further (surround) channels are left silent.
+// scale and offset map -1..1 onto the sample type's range.
+template <typename Sample>
+void storeFrames(Uint8* stream, const float* left, const float* right, int frames, float scale, float offset) {
+    Sample* out = reinterpret_cast<Sample*>(stream);
+    for (int i = 0; i < frames; ++i) {
+        out[0] = static_cast<Sample>(std::max(-1.0f, std::min(1.0f, left[i])) * scale + offset);
+        if (g_channels > 1) {
+            out[1] = static_cast<Sample>(std::max(-1.0f, std::min(1.0f, right[i])) * scale + offset);
+        }
+        for (int c = 2; c < g_channels; ++c) {
+            out[c] = static_cast<Sample>(offset);
+        }
+        out += g_channels;
+    }
+}
+
+void writeFrames(Uint8* stream, const float* left, const float* right, int frames) {
+    switch (g_format) {
+        case AUDIO_F32SYS: storeFrames<float>(stream, left, right, frames, 1.0f, 0.0f); break;
+        case AUDIO_S32SYS: storeFrames<Sint32>(stream, left, right, frames, 2147483520.0f, 0.0f); break; // Largest float below 2^31
+        case AUDIO_U8: storeFrames<Uint8>(stream, left, right, frames, 127.0f, 128.0f); break;
+        case AUDIO_S8: storeFrames<Sint8>(stream, left, right, frames, 127.0f, 0.0f); break;
+        default: storeFrames<Sint16>(stream, left, right, frames, 32767.0f, 0.0f); break;
+    }
+}
+
+// --- Visualiser: the audio thread hands its latest samples to the UI thread ---
+
+const int SCOPE_SAMPLES = 1024; // Samples per visualiser frame; a power of two for the FFT.
+
+struct ScopeFrame {
+    float samples[SCOPE_SAMPLES];
+    int sampleRate;
+};
+
+// Wait-free triple buffer. The audio thread always owns one slot to write into and the UI thread
+// one to read from; the third holds the latest finished frame. Publishing and picking up a frame
+// are each a single atomic exchange, so neither thread can ever block or delay the other.
+class TripleBuffer {
+public:
+    // The slot the writer fills in before calling publish().
+    ScopeFrame& writeSlot() { return slots[writeIndex]; }
+
+    void publish() {
+        writeIndex = spare.exchange(writeIndex | FRESH, std::memory_order_acq_rel) & INDEX_MASK;
+    }
+
+    // Swap in the latest published frame, if there is one the reader has not seen yet.
+    bool fetch() {
+        if (!(spare.load(std::memory_order_relaxed) & FRESH)) {
+            return false;
+        }
+        readIndex = spare.exchange(readIndex, std::memory_order_acq_rel) & INDEX_MASK;
+        return true;
+    }
+
+    const ScopeFrame& readSlot() const { return slots[readIndex]; }
+
+private:
+    static const int INDEX_MASK = 3;
+    static const int FRESH = 4; // Set on the spare index when it holds a frame not read yet.
+
+    ScopeFrame slots[3] = {};
+    std::atomic<int> spare{1};
+    int writeIndex = 0; // Only touched by the audio thread.
+    int readIndex = 2;  // Only touched by the UI thread.
+};
+
+TripleBuffer g_scope;
+
+// The most recent mono samples, kept by the audio thread as a ring.
+float g_scopeHistory[SCOPE_SAMPLES] = {};
+int g_scopePosition = 0;
+
+// This callback function is called by SDL whenever it needs more audio data.
+// It writes straight into the device's own rate, channel count and sample format.
+void audio_callback(void* userdata, Uint8* stream, int len) {
+    int frameBytes = SDL_AUDIO_BITSIZE(g_format) / 8 * g_channels;
+    int num_frames = len / frameBytes;
+    bool stereo = g_channels > 1;
+
+    // Work through the buffer one control block at a time.
+    for (int start = 0; start < num_frames; start += CONTROL_BLOCK) {
+        int frames = std::min(CONTROL_BLOCK, num_frames - start);
+        float left[CONTROL_BLOCK] = {};
+        float right[CONTROL_BLOCK] = {};
+
+        for (Voice& voice : g_voices) {
+            if (voice.stage != ENVELOPE_OFF) {
+                renderVoice(voice, left, stereo ? right : nullptr, frames);
+            }
+        }
+
+        // Keep the mono mix for the visualiser.
+        for (int i = 0; i < frames; ++i) {
+            g_scopeHistory[g_scopePosition] = stereo ? 0.5f * (left[i] + right[i]) : left[i];
+            g_scopePosition = (g_scopePosition + 1) & (SCOPE_SAMPLES - 1);
+        }
+
+        writeFrames(stream + start * frameBytes, left, right, frames);
+    }
+
+    // Hand the latest samples, oldest first, to the UI thread.
+    ScopeFrame& frame = g_scope.writeSlot();
+    for (int i = 0; i < SCOPE_SAMPLES; ++i) {
+        frame.samples[i] = g_scopeHistory[(g_scopePosition + i) & (SCOPE_SAMPLES - 1)];
+    }
+    frame.sampleRate = g_sampleRate;
+    g_scope.publish();
+}
+
+// Radix-2 FFT of one visualiser frame, giving the level of each frequency bin in decibels.
+// Every table and buffer is allocated once, up front.
+class Spectrum {
+public:
+    static const int BINS = SCOPE_SAMPLES / 2;
+    float decibels[BINS];
+
+    Spectrum() : bitReverse(SCOPE_SAMPLES), cosTable(BINS), sinTable(BINS), window(SCOPE_SAMPLES),
+                 real(SCOPE_SAMPLES), imag(SCOPE_SAMPLES) {
+        int bits = 0;
+        while ((1 << bits) < SCOPE_SAMPLES) {
+            bits++;
+        }
+        for (int i = 0; i < SCOPE_SAMPLES; ++i) {
+            int reversed = 0;
+            for (int b = 0; b < bits; ++b) {
+                reversed |= ((i >> b) & 1) << (bits - 1 - b);
+            }
+            bitReverse[i] = reversed;
+        }
+        for (int k = 0; k < BINS; ++k) {
+            cosTable[k] = static_cast<float>(std::cos(2.0 * M_PI * k / SCOPE_SAMPLES));
+            sinTable[k] = static_cast<float>(std::sin(2.0 * M_PI * k / SCOPE_SAMPLES));
+        }
+
+        // Hann window, to keep a note's energy from leaking across the whole spectrum.
+        double windowSum = 0.0;
+        for (int i = 0; i < SCOPE_SAMPLES; ++i) {
+            window[i] = static_cast<float>(0.5 - 0.5 * std::cos(2.0 * M_PI * i / SCOPE_SAMPLES));
+            windowSum += window[i];
+        }
+        // Scale so a full-scale sine reads 0 dB.
+        amplitudeScale = static_cast<float>(2.0 / windowSum);
+        std::fill(decibels, decibels + BINS, -120.0f);
+    }
+
+    void compute(const float* samples) {
+        for (int i = 0; i < SCOPE_SAMPLES; ++i) {
+            real[bitReverse[i]] = samples[i] * window[i];
+            imag[bitReverse[i]] = 0.0f;
+        }
+
+        // Iterative Cooley-Tukey butterflies.
+        for (int size = 2; size <= SCOPE_SAMPLES; size *= 2) {
+            int half = size / 2;
+            int tableStep = SCOPE_SAMPLES / size;
+            for (int start = 0; start < SCOPE_SAMPLES; start += size) {
+                for (int k = 0; k < half; ++k) {
+                    float wr = cosTable[k * tableStep];
+                    float wi = -sinTable[k * tableStep];
+                    int a = start + k;
+                    int b = a + half;
+                    float tr = wr * real[b] - wi * imag[b];
+                    float ti = wr * imag[b] + wi * real[b];
+                    real[b] = real[a] - tr;
+                    imag[b] = imag[a] - ti;
+                    real[a] += tr;
+                    imag[a] += ti;
+                }
+            }
+        }
+
+        for (int k = 0; k < BINS; ++k) {
+            float magnitude = std::sqrt(real[k] * real[k] + imag[k] * imag[k]) * amplitudeScale;
+            decibels[k] = 20.0f * std::log10(magnitude + 1e-6f);
+        }
+    }
+
+private:
+    std::vector<int> bitReverse;
+    std::vector<float> cosTable;
+    std::vector<float> sinTable;
+    std::vector<float> window;
+    std::vector<float> real;
+    std::vector<float> imag;
+    float amplitudeScale;
+};
+
+// Draw the oscilloscope in the top half of the window and the spectrum in the bottom half.
+// points and bars are reused from frame to frame, so drawing does not allocate once they have grown.
+void drawVisualiser(SDL_Renderer* renderer, const ScopeFrame& frame, const Spectrum& spectrum,
+                    std::vector<SDL_Point>& points, std::vector<SDL_Rect>& bars) {
+    int width = 0;
+    int height = 0;
+    SDL_GetRendererOutputSize(renderer, &width, &height);
+    int scopeHeight = height / 2;
+
+    SDL_SetRenderDrawColor(renderer, 16, 16, 24, 255);
+    SDL_RenderClear(renderer);
+
+    // Start the trace at a rising zero crossing, so a steady note stands still on screen.
+    const int shown = SCOPE_SAMPLES / 2;
+    int trigger = 0;
+    for (int i = 1; i < SCOPE_SAMPLES - shown; ++i) {
+        if (frame.samples[i - 1] < 0.0f && frame.samples[i] >= 0.0f) {
+            trigger = i;
+            break;
+        }
+    }
+
+    points.resize(width);
+    for (int x = 0; x < width; ++x) {
+        float sample = frame.samples[trigger + x * (shown - 1) / std::max(1, width - 1)];
+        points[x].x = x;
+        points[x].y = static_cast<int>(scopeHeight * (0.5f - 0.45f * sample));
+    }
+    SDL_SetRenderDrawColor(renderer, 80, 255, 120, 255);
+    SDL_RenderDrawLines(renderer, points.data(), width);
+
+    // Spectrum on a log frequency axis from 40 Hz up to Nyquist, -80..0 dB.
+    // A frame without a sample rate has no frequency axis, so it gets no spectrum.
+    double binHz = static_cast<double>(frame.sampleRate) / SCOPE_SAMPLES;
+    if (binHz > 0.0) {
+        const float minDecibels = -80.0f;
+        double highBin = Spectrum::BINS - 1;
+        double lowBin = std::min(highBin, std::max(1.0, 40.0 / binHz));
+        int spectrumHeight = height - scopeHeight;
+
+        bars.resize(width);
+        for (int x = 0; x < width; ++x) {
+            int bin = static_cast<int>(lowBin * std::pow(highBin / lowBin, static_cast<double>(x) / std::max(1, width - 1)));
+            bin = std::max(0, std::min(Spectrum::BINS - 1, bin));
+            float level = (std::max(minDecibels, spectrum.decibels[bin]) - minDecibels) / -minDecibels;
+            int barHeight = static_cast<int>(level * spectrumHeight);
+            bars[x] = {x, height - barHeight, 1, barHeight};
+        }
+        SDL_SetRenderDrawColor(renderer, 255, 160, 60, 255);
+        SDL_RenderFillRects(renderer, bars.data(), width);
+    }
+
+    SDL_RenderPresent(renderer);
+}
+
+// Function to get the note played by a key, or -1 if the key is not a piano key
+int keyToNote(int key) {
+    switch (key) {
+        case SDLK_a: return 60; // C4
+        case SDLK_s: return 62; // D4
+        case SDLK_d: return 64; // E4
+        case SDLK_f: return 65; // F4
+        case SDLK_g: return 67; // G4
+        case SDLK_h: return 69; // A4
+        case SDLK_j: return 71; // B4
+        case SDLK_k: return 72; // C5
+        default: return -1;
+    }
+}
+
 int main(int argc, char* argv[]) {
     // Initialize SDL's audio and video subsystems
     if (SDL_Init(SDL_INIT_AUDIO | SDL_INIT_VIDEO) < 0) {
@@ -66,13 +546,32 @@ int main(int argc, char* argv[]) {
     desired.samples = SAMPLES_PER_BUFFER;
     desired.callback = audio_callback;
 
-    // Open the audio device
-    SDL_AudioDeviceID deviceId = SDL_OpenAudioDevice(NULL, 0, &desired, NULL, 0);
+    // Open the audio device, taking whatever rate, channel count and format it runs at natively.
+    // Otherwise SDL would convert every buffer from our format to the device's.
+    SDL_AudioSpec obtained;
+    int allowedChanges = SDL_AUDIO_ALLOW_FREQUENCY_CHANGE | SDL_AUDIO_ALLOW_CHANNELS_CHANGE |
+                         SDL_AUDIO_ALLOW_FORMAT_CHANGE | SDL_AUDIO_ALLOW_SAMPLES_CHANGE;
+    SDL_AudioDeviceID deviceId = SDL_OpenAudioDevice(NULL, 0, &desired, &obtained, allowedChanges);
+    bool sdlConvertsFormat = false;
+    if (deviceId != 0 && !canGenerate(obtained.format)) {
+        // We cannot write this format ourselves, so let SDL convert from s16.
+        std::cout << "Device wants " << formatName(obtained.format) << ", letting SDL convert from s16" << std::endl;
+        SDL_CloseAudioDevice(deviceId);
+        allowedChanges &= ~SDL_AUDIO_ALLOW_FORMAT_CHANGE;
+        deviceId = SDL_OpenAudioDevice(NULL, 0, &desired, &obtained, allowedChanges);
+        sdlConvertsFormat = true;
+    }
     if (deviceId == 0) {
         std::cerr << "Failed to open audio device! SDL Error: " << SDL_GetError() << std::endl;
         SDL_Quit();
         return 1;
     }
+    configureOutput(obtained);
+
+    std::cout << "Audio output: " << obtained.freq << " Hz, " << static_cast<int>(obtained.channels)
+              << " channel(s), " << formatName(obtained.format) << ", " << obtained.samples
+              << " frames per buffer, " << (sdlConvertsFormat ? "format converted by SDL" : "generated natively")
+              << " (driver: " << SDL_GetCurrentAudioDriver() << ")" << std::endl;
 
     // Start playing audio
     SDL_PauseAudioDevice(deviceId, 0);
@@ -90,48 +589,101 @@ int main(int argc, char* argv[]) {
         return 1;
     }
     
+    // The visualiser is drawn with vsync, so presenting a frame also paces the main loop.
+    SDL_Renderer* renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
+    if (renderer == NULL) {
+        renderer = SDL_CreateRenderer(window, -1, 0);
+    }
+    if (renderer == NULL) {
+        std::cerr << "Renderer could not be created! SDL Error: " << SDL_GetError() << std::endl;
+        SDL_DestroyWindow(window);
+        SDL_CloseAudioDevice(deviceId);
+        SDL_Quit();
+        return 1;
+    }
+    SDL_RendererInfo rendererInfo;
+    SDL_GetRendererInfo(renderer, &rendererInfo);
+    bool vsync = (rendererInfo.flags & SDL_RENDERER_PRESENTVSYNC) != 0;
+
+    Spectrum spectrum;
+    std::vector<SDL_Point> scopePoints;
+    std::vector<SDL_Rect> spectrumBars;
+    bool haveScopeFrame = false;
+
     std::cout << "Chiptune Piano is running. Press keys for notes." << std::endl;
     std::cout << "Keys: A=C, S=D, D=E, F=F, G=G, H=A, J=B, K=C (Octave 5)" << std::endl;
     std::cout << "Press 'Q' to quit." << std::endl;
 
+    std::cout << "Effects: 1=Vibrato, 2=Arpeggio, 3=Pitch slide (toggle)" << std::endl;
+
     bool quit = false;
     SDL_Event event;
     while (!quit) {
         while (SDL_PollEvent(&event) != 0) {
             if (event.type == SDL_QUIT) {
                 quit = true;
-            } else if (event.type == SDL_KEYDOWN) {
-                switch (event.key.keysym.sym) {
-                    case SDLK_a: g_frequency = noteToFrequency(60); break; // C4
-                    case SDLK_s: g_frequency = noteToFrequency(62); break; // D4
-                    case SDLK_d: g_frequency = noteToFrequency(64); break; // E4
-                    case SDLK_f: g_frequency = noteToFrequency(65); break; // F4
-                    case SDLK_g: g_frequency = noteToFrequency(67); break; // G4
-                    case SDLK_h: g_frequency = noteToFrequency(69); break; // A4
-                    case SDLK_j: g_frequency = noteToFrequency(71); break; // B4
-                    case SDLK_k: g_frequency = noteToFrequency(72); break; // C5
-                    case SDLK_q: quit = true; break;
+            } else if (event.type == SDL_KEYDOWN && !event.key.repeat) {
+                int key = event.key.keysym.sym;
+                int note = keyToNote(key);
+
+                // The audio thread reads the voices and effect switches, so lock it out while we change them.
+                // Anything we print waits until it is unlocked again, so slow console output cannot stall the audio.
+                const char* effectName = nullptr;
+                bool effectOn = false;
+                SDL_LockAudioDevice(deviceId);
+                if (note >= 0) {
+                    noteOn(key, note);
+                } else if (key == SDLK_1) {
+                    g_vibrato = !g_vibrato;
+                    effectName = "Vibrato";
+                    effectOn = g_vibrato;
+                } else if (key == SDLK_2) {
+                    g_arpeggio = !g_arpeggio;
+                    effectName = "Arpeggio";
+                    effectOn = g_arpeggio;
+                } else if (key == SDLK_3) {
+                    g_slide = !g_slide;
+                    effectName = "Pitch slide";
+                    effectOn = g_slide;
+                } else if (key == SDLK_q) {
+                    quit = true;
+                }
+                SDL_UnlockAudioDevice(deviceId);
+
+                if (effectName != nullptr) {
+                    std::cout << effectName << " " << (effectOn ? "on" : "off") << std::endl;
                 }
             } else if (event.type == SDL_KEYUP) {
-                // Stop the sound when the key is released
-                switch (event.key.keysym.sym) {
-                    case SDLK_a:
-                    case SDLK_s:
-                    case SDLK_d:
-                    case SDLK_f:
-                    case SDLK_g:
-                    case SDLK_h:
-                    case SDLK_j:
-                    case SDLK_k:
-                        g_frequency = 0.0;
-                        break;
+                // Release the note when its key is let go
+                if (keyToNote(event.key.keysym.sym) >= 0) {
+                    SDL_LockAudioDevice(deviceId);
+                    noteOff(event.key.keysym.sym);
+                    SDL_UnlockAudioDevice(deviceId);
                 }
             }
         }
-        SDL_Delay(10); // Don't hog the CPU
+
+        // Pick up the newest samples from the audio thread, if there are any, and draw them.
+        // Until the first audio callback has run there is nothing to show, so just clear the window
+        // (still presenting it, which keeps the loop paced by vsync).
+        if (g_scope.fetch()) {
+            spectrum.compute(g_scope.readSlot().samples);
+            haveScopeFrame = true;
+        }
+        if (haveScopeFrame) {
+            drawVisualiser(renderer, g_scope.readSlot(), spectrum, scopePoints, spectrumBars);
+        } else {
+            SDL_SetRenderDrawColor(renderer, 16, 16, 24, 255);
+            SDL_RenderClear(renderer);
+            SDL_RenderPresent(renderer);
+        }
+        if (!vsync) {
+            SDL_Delay(16); // No vsync, so don't hog the CPU; about 60 frames per second
+        }
     }
 
     // Clean up
+    SDL_DestroyRenderer(renderer);
     SDL_DestroyWindow(window);
     SDL_CloseAudioDevice(deviceId);
     SDL_Quit();
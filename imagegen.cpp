@@ -1,10 +1,657 @@
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <algorithm>
+#include <cmath>
+#include <cctype>
+#include <climits>
+#include <cstdio>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// Write a width x height image filled with one colour, as plain (P3) PPM.
+void writeImage(std::ostream& out, int width, int height, int r, int g, int b) {
+	//Write ppm header
+	out << "P3" << std::endl;
+	out << width << " " << height << std::endl;
+	out << "255" << std::endl;
+
+	//Every pixel is the same, so format it once
+	std::string pixel = std::to_string(r) + " " + std::to_string(g) + " " + std::to_string(b) + " ";
+
+	//Write the pixel data
+	for (int y = 0; y < height; ++y) {
+		for (int x = 0; x < width; ++x) {
+			out << pixel;
+		}
+		out << '\n';
+	}
+}
+
+// --- Streaming pipeline: read a PPM, pass it through a chain of row operations, write it out ---
+// Only a few rows are in memory at any time, so this works on images far bigger than RAM.
+// The reader, every operation and the writer each run on their own thread.
+
+// One row of pixels as interleaved R, G, B floats in the range 0..255.
+typedef std::vector<float> Row;
+
+// Widest row the pipeline handles, so that width * 3 always fits in an int.
+const int MAX_ROW_WIDTH = INT_MAX / 3;
+
+// Rows waiting between two pipeline threads. push() waits while the queue is full, so a fast
+// stage cannot run ahead and fill up memory. pop() returns false once the queue is closed and empty.
+class RowQueue {
+public:
+	explicit RowQueue(size_t capacity) : capacity(capacity), closed(false) {}
+
+	void push(Row&& row) {
+		std::unique_lock<std::mutex> lock(mutex);
+		notFull.wait(lock, [this] { return rows.size() < capacity; });
+		rows.push_back(std::move(row));
+		notEmpty.notify_one();
+	}
+
+	bool pop(Row& row) {
+		std::unique_lock<std::mutex> lock(mutex);
+		notEmpty.wait(lock, [this] { return !rows.empty() || closed; });
+		if (rows.empty()) {
+			return false;
+		}
+		row = std::move(rows.front());
+		rows.pop_front();
+		notFull.notify_one();
+		return true;
+	}
+
+	void close() {
+		std::lock_guard<std::mutex> lock(mutex);
+		closed = true;
+		notEmpty.notify_all();
+	}
+
+private:
+	size_t capacity;
+	bool closed;
+	std::deque<Row> rows;
+	std::mutex mutex;
+	std::condition_variable notFull;
+	std::condition_variable notEmpty;
+};
+
+// Row kernels. These do the per-pixel work of the operations, four floats at a time with SSE.
+
+// out[i] += weight * in[i]
+void addScaledRow(float* out, const float* in, float weight, int count) {
+	int i = 0;
+#ifdef __SSE2__
+	__m128 w = _mm_set1_ps(weight);
+	for (; i + 4 <= count; i += 4) {
+		__m128 sum = _mm_add_ps(_mm_loadu_ps(out + i), _mm_mul_ps(_mm_loadu_ps(in + i), w));
+		_mm_storeu_ps(out + i, sum);
+	}
+#endif
+	for (; i < count; ++i) {
+		out[i] += weight * in[i];
+	}
+}
+
+// Multiply each channel of an RGB row by its own factor. Three SSE registers hold the
+// factors for 12 floats (4 pixels), where the R, G, B pattern lines up again.
+void scaleRowRgb(float* data, int count, const float factor[3]) {
+	int i = 0;
+#ifdef __SSE2__
+	__m128 f0 = _mm_setr_ps(factor[0], factor[1], factor[2], factor[0]);
+	__m128 f1 = _mm_setr_ps(factor[1], factor[2], factor[0], factor[1]);
+	__m128 f2 = _mm_setr_ps(factor[2], factor[0], factor[1], factor[2]);
+	for (; i + 12 <= count; i += 12) {
+		_mm_storeu_ps(data + i, _mm_mul_ps(_mm_loadu_ps(data + i), f0));
+		_mm_storeu_ps(data + i + 4, _mm_mul_ps(_mm_loadu_ps(data + i + 4), f1));
+		_mm_storeu_ps(data + i + 8, _mm_mul_ps(_mm_loadu_ps(data + i + 8), f2));
+	}
+#endif
+	for (; i < count; ++i) {
+		data[i] *= factor[i % 3];
+	}
+}
+
+// Round and clamp a row to bytes.
+void rowToBytes(const float* in, unsigned char* out, int count) {
+	int i = 0;
+#ifdef __SSE2__
+	// Clamp, add 0.5 and truncate, the same rounding as the scalar tail below.
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 max = _mm_set1_ps(255.0f);
+	const __m128 half = _mm_set1_ps(0.5f);
+	for (; i + 8 <= count; i += 8) {
+		__m128 lowValues = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(in + i), zero), max);
+		__m128 highValues = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(in + i + 4), zero), max);
+		__m128i low = _mm_cvttps_epi32(_mm_add_ps(lowValues, half));
+		__m128i high = _mm_cvttps_epi32(_mm_add_ps(highValues, half));
+		__m128i words = _mm_packs_epi32(low, high);
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(out + i), _mm_packus_epi16(words, words));
+	}
+#endif
+	for (; i < count; ++i) {
+		float value = in[i] < 0.0f ? 0.0f : (in[i] > 255.0f ? 255.0f : in[i]);
+		out[i] = static_cast<unsigned char>(value + 0.5f);
+	}
+}
+
+// Round and clamp a row to samples of 0..maxValue, for output that is not 8-bit.
+void rowToSamples(const float* in, int* out, int count, int maxValue) {
+	float scale = maxValue / 255.0f;
+	for (int i = 0; i < count; ++i) {
+		float value = in[i] < 0.0f ? 0.0f : (in[i] > 255.0f ? 255.0f : in[i]);
+		out[i] = std::min(maxValue, static_cast<int>(value * scale + 0.5f));
+	}
+}
+
+// One operation of the pipeline. Rows arrive top to bottom through process(), and the stage
+// pushes its own output rows, also top to bottom, to out.
+class Stage {
+public:
+	virtual ~Stage() {}
+
+	// Called once before any rows arrive: takes the input size and changes it to the output size.
+	// Returns false if the rows would be too wide for the stage to hold.
+	virtual bool configure(int& width, int& height) = 0;
+
+	virtual void process(Row& row, RowQueue& out) = 0;
+
+	// Called after the last input row, to send out any rows held back.
+	virtual void finish(RowQueue& out) {}
+};
+
+// Separable Gaussian blur. Each row is blurred horizontally as it arrives; the vertical pass
+// then only needs a sliding window of the last 2 * radius + 1 rows.
+class BlurStage : public Stage {
+public:
+	explicit BlurStage(double sigma) {
+		radius = std::max(1, static_cast<int>(std::ceil(3.0 * sigma)));
+		double sum = 0.0;
+		for (int k = -radius; k <= radius; ++k) {
+			double weight = std::exp(-(k * k) / (2.0 * sigma * sigma));
+			weights.push_back(static_cast<float>(weight));
+			sum += weight;
+		}
+		for (float& weight : weights) {
+			weight = static_cast<float>(weight / sum);
+		}
+	}
+
+	bool configure(int& w, int& h) override {
+		if (w > MAX_ROW_WIDTH - 2 * radius) {
+			return false;
+		}
+		width = w;
+		height = h;
+		window.assign(2 * radius + 1, Row(width * 3));
+		padded.assign((width + 2 * radius) * 3, 0.0f);
+		received = 0;
+		emitted = 0;
+		return true;
+	}
+
+	void process(Row& row, RowQueue& out) override {
+		// Repeat the edge pixels past both ends, so the horizontal pass needs no bounds checks.
+		std::copy(row.begin(), row.end(), padded.begin() + radius * 3);
+		for (int p = 0; p < radius; ++p) {
+			std::copy(row.begin(), row.begin() + 3, padded.begin() + p * 3);
+			std::copy(row.end() - 3, row.end(), padded.end() - (p + 1) * 3);
+		}
+
+		Row& blurred = window[received % window.size()];
+		std::fill(blurred.begin(), blurred.end(), 0.0f);
+		for (size_t k = 0; k < weights.size(); ++k) {
+			addScaledRow(blurred.data(), padded.data() + k * 3, weights[k], width * 3);
+		}
+		received++;
+
+		// Output row y needs the input rows down to y + radius.
+		while (emitted < height && emitted + radius < received) {
+			emitRow(out);
+		}
+	}
+
+	void finish(RowQueue& out) override {
+		while (emitted < received) {
+			emitRow(out);
+		}
+	}
+
+private:
+	void emitRow(RowQueue& out) {
+		Row result(width * 3, 0.0f);
+		int lastRow = std::min(height, received) - 1;
+		for (int k = 0; k <= 2 * radius; ++k) {
+			int source = std::max(0, std::min(lastRow, emitted + k - radius));
+			addScaledRow(result.data(), window[source % window.size()].data(), weights[k], width * 3);
+		}
+		out.push(std::move(result));
+		emitted++;
+	}
+
+	int radius;
+	std::vector<float> weights;
+	int width;
+	int height;
+	std::vector<Row> window;
+	Row padded;
+	int received;
+	int emitted;
+};
+
+// Box resize: every output pixel is the average of the input pixels it covers, counting
+// partly covered pixels by how much of them it covers. Works for shrinking and growing.
+class ResizeStage : public Stage {
+public:
+	ResizeStage(int width, int height) : outWidth(width), outHeight(height) {}
+
+	bool configure(int& w, int& h) override {
+		if (outWidth > MAX_ROW_WIDTH) {
+			return false;
+		}
+		inWidth = w;
+		inHeight = h;
+		scaleY = static_cast<double>(inHeight) / outHeight;
+
+		// Which input pixels each output pixel covers, and by how much.
+		double scaleX = static_cast<double>(inWidth) / outWidth;
+		tapStart.assign(1, 0);
+		tapPixel.clear();
+		tapWeight.clear();
+		for (int x = 0; x < outWidth; ++x) {
+			double left = x * scaleX;
+			double right = (x + 1) * scaleX;
+			for (int p = static_cast<int>(left); p < inWidth && p < right; ++p) {
+				double overlap = std::min(right, p + 1.0) - std::max(left, static_cast<double>(p));
+				if (overlap > 0.0) {
+					tapPixel.push_back(p);
+					tapWeight.push_back(static_cast<float>(overlap / scaleX));
+				}
+			}
+			tapStart.push_back(static_cast<int>(tapPixel.size()));
+		}
+
+		pending.clear();
+		received = 0;
+		nextOutput = 0;
+		w = outWidth;
+		h = outHeight;
+		return true;
+	}
+
+	void process(Row& row, RowQueue& out) override {
+		Row resized(outWidth * 3, 0.0f);
+		for (int x = 0; x < outWidth; ++x) {
+			float* pixel = &resized[x * 3];
+			for (int t = tapStart[x]; t < tapStart[x + 1]; ++t) {
+				const float* source = &row[tapPixel[t] * 3];
+				pixel[0] += tapWeight[t] * source[0];
+				pixel[1] += tapWeight[t] * source[1];
+				pixel[2] += tapWeight[t] * source[2];
+			}
+		}
+
+		// Add this input row to every output row it overlaps.
+		double top = received;
+		double bottom = received + 1.0;
+		for (int y = nextOutput; y < outHeight && y * scaleY < bottom; ++y) {
+			while (static_cast<int>(pending.size()) <= y - nextOutput) {
+				pending.push_back(Row(outWidth * 3, 0.0f));
+			}
+			double overlap = std::min((y + 1) * scaleY, bottom) - std::max(y * scaleY, top);
+			if (overlap > 0.0) {
+				addScaledRow(pending[y - nextOutput].data(), resized.data(),
+				             static_cast<float>(overlap / scaleY), outWidth * 3);
+			}
+		}
+		received++;
+
+		// Send out the rows that no later input row can reach.
+		while (!pending.empty() && (nextOutput + 1) * scaleY <= received + 1e-9) {
+			out.push(std::move(pending.front()));
+			pending.pop_front();
+			nextOutput++;
+		}
+	}
+
+	void finish(RowQueue& out) override {
+		while (!pending.empty()) {
+			out.push(std::move(pending.front()));
+			pending.pop_front();
+			nextOutput++;
+		}
+	}
+
+private:
+	int outWidth;
+	int outHeight;
+	int inWidth;
+	int inHeight;
+	double scaleY;
+	std::vector<int> tapStart;
+	std::vector<int> tapPixel;
+	std::vector<float> tapWeight;
+	std::deque<Row> pending;
+	int received;
+	int nextOutput;
+};
+
+// Colour tint: multiplies the image by a colour, blended with the original by amount (0..1).
+class TintStage : public Stage {
+public:
+	TintStage(int r, int g, int b, double amount) {
+		factor[0] = static_cast<float>(1.0 - amount + amount * r / 255.0);
+		factor[1] = static_cast<float>(1.0 - amount + amount * g / 255.0);
+		factor[2] = static_cast<float>(1.0 - amount + amount * b / 255.0);
+	}
+
+	bool configure(int&, int&) override { return true; }
+
+	void process(Row& row, RowQueue& out) override {
+		scaleRowRgb(row.data(), static_cast<int>(row.size()), factor);
+		out.push(std::move(row));
+	}
+
+private:
+	float factor[3];
+};
+
+// Crop to a rectangle; parts of it outside the image are dropped.
+class CropStage : public Stage {
+public:
+	CropStage(int x, int y, int width, int height) : left(x), top(y), cropWidth(width), cropHeight(height) {}
+
+	bool configure(int& w, int& h) override {
+		left = std::max(0, std::min(left, w));
+		top = std::max(0, std::min(top, h));
+		cropWidth = std::max(0, std::min(cropWidth, w - left));
+		cropHeight = std::max(0, std::min(cropHeight, h - top));
+		rowIndex = 0;
+		w = cropWidth;
+		h = cropHeight;
+		return true;
+	}
+
+	void process(Row& row, RowQueue& out) override {
+		if (rowIndex >= top && rowIndex < top + cropHeight) {
+			out.push(Row(row.begin() + left * 3, row.begin() + (left + cropWidth) * 3));
+		}
+		rowIndex++;
+	}
+
+private:
+	int left;
+	int top;
+	int cropWidth;
+	int cropHeight;
+	int rowIndex;
+};
+
+// Largest blur accepted, which keeps the blur radius (3 * sigma) well inside an int.
+const double MAX_BLUR_SIGMA = 10000.0;
+
+// Parse one operation from the command line, e.g. "blur:2", "resize:640x480",
+// "tint:FF8000:0.5" or "crop:10,10,200,100". Returns nullptr if it makes no sense.
+std::unique_ptr<Stage> parseStage(const std::string& operation) {
+	char hexColor[7] = {};
+	double value = 0.0;
+	int a = 0;
+	int b = 0;
+	int c = 0;
+	int d = 0;
+
+	if (std::sscanf(operation.c_str(), "blur:%lf", &value) == 1 && value > 0.0 && value <= MAX_BLUR_SIGMA) {
+		return std::unique_ptr<Stage>(new BlurStage(value));
+	}
+	if (std::sscanf(operation.c_str(), "resize:%dx%d", &a, &b) == 2 && a > 0 && b > 0) {
+		return std::unique_ptr<Stage>(new ResizeStage(a, b));
+	}
+	if (std::sscanf(operation.c_str(), "crop:%d,%d,%d,%d", &a, &b, &c, &d) == 4 && a >= 0 && b >= 0 && c > 0 && d > 0) {
+		return std::unique_ptr<Stage>(new CropStage(a, b, c, d));
+	}
+	value = 0.5;
+	int fields = std::sscanf(operation.c_str(), "tint:%6[0-9a-fA-F]:%lf", hexColor, &value);
+	if (fields >= 1 && std::string(hexColor).length() == 6 && value >= 0.0 && value <= 1.0) {
+		int color = std::stoi(hexColor, nullptr, 16);
+		return std::unique_ptr<Stage>(new TintStage((color >> 16) & 0xFF, (color >> 8) & 0xFF, color & 0xFF, value));
+	}
+	return nullptr;
+}
+
+// Read the next number of a PPM header or P3 body, skipping whitespace and # comments.
+// The character after the number is consumed too, which is what P6 expects after the header.
+bool readPpmNumber(std::streambuf* in, int& value) {
+	int c = in->sbumpc();
+	while (c != EOF && (std::isspace(c) || c == '#')) {
+		if (c == '#') {
+			while (c != EOF && c != '\n') {
+				c = in->sbumpc();
+			}
+		}
+		c = in->sbumpc();
+	}
+	if (c == EOF || !std::isdigit(c)) {
+		return false;
+	}
+	value = 0;
+	while (c != EOF && std::isdigit(c)) {
+		if (value > (INT_MAX - (c - '0')) / 10) {
+			return false; // Too big for an int
+		}
+		value = value * 10 + (c - '0');
+		c = in->sbumpc();
+	}
+	return true;
+}
+
+struct PpmHeader {
+	bool binary; // P6 rather than P3
+	int width;
+	int height;
+	int maxValue;
+};
+
+bool readPpmHeader(std::streambuf* in, PpmHeader& header) {
+	if (in->sbumpc() != 'P') {
+		return false;
+	}
+	int kind = in->sbumpc();
+	if (kind != '3' && kind != '6') {
+		return false;
+	}
+	header.binary = kind == '6';
+	return readPpmNumber(in, header.width) && readPpmNumber(in, header.height) &&
+	       readPpmNumber(in, header.maxValue) && header.width > 0 && header.width <= MAX_ROW_WIDTH &&
+	       header.height > 0 && header.maxValue > 0 && header.maxValue < 65536;
+}
+
+// Read one row of pixels and scale it to 0..255. bytes is scratch space for P6 rows.
+bool readPpmRow(std::streambuf* in, const PpmHeader& header, Row& row, std::vector<unsigned char>& bytes) {
+	int count = header.width * 3;
+	float scale = 255.0f / header.maxValue;
+
+	if (!header.binary) {
+		for (int i = 0; i < count; ++i) {
+			int value = 0;
+			if (!readPpmNumber(in, value)) {
+				return false;
+			}
+			row[i] = value * scale;
+		}
+		return true;
+	}
+
+	// Binary samples are one byte each, or two (big-endian) when maxValue is above 255.
+	int sampleBytes = header.maxValue > 255 ? 2 : 1;
+	bytes.resize(static_cast<size_t>(count) * sampleBytes);
+	if (in->sgetn(reinterpret_cast<char*>(bytes.data()), bytes.size()) != static_cast<std::streamsize>(bytes.size())) {
+		return false;
+	}
+	for (int i = 0; i < count; ++i) {
+		int value = sampleBytes == 1 ? bytes[i] : (bytes[2 * i] << 8 | bytes[2 * i + 1]);
+		row[i] = value * scale;
+	}
+	return true;
+}
+
+// Run inputPath through the given operations into outputPath, in the same PPM flavour.
+int runPipeline(const std::string& inputPath, const std::string& outputPath, const std::vector<std::string>& operations) {
+	std::vector<std::unique_ptr<Stage>> stages;
+	for (const std::string& operation : operations) {
+		std::unique_ptr<Stage> stage = parseStage(operation);
+		if (!stage) {
+			std::cerr << "Error, unknown operation: " << operation << std::endl;
+			return 1;
+		}
+		stages.push_back(std::move(stage));
+	}
+
+	std::ifstream infile(inputPath, std::ios::binary);
+	PpmHeader header;
+	if (!infile || !readPpmHeader(infile.rdbuf(), header)) {
+		std::cerr << "Error, " << inputPath << " is not a P3 or P6 PPM file" << std::endl;
+		return 1;
+	}
+
+	int width = header.width;
+	int height = header.height;
+	for (size_t i = 0; i < stages.size(); ++i) {
+		if (!stages[i]->configure(width, height)) {
+			std::cerr << "Error, the image is too wide for " << operations[i] << std::endl;
+			return 1;
+		}
+	}
+	if (width <= 0 || height <= 0) {
+		std::cerr << "Error, the operations leave an empty image" << std::endl;
+		return 1;
+	}
+
+	std::ofstream outfile(outputPath, std::ios::binary);
+	if (!outfile) {
+		std::cerr << "Error, cannot write " << outputPath << std::endl;
+		return 1;
+	}
+
+	// One queue in front of every stage and one in front of the writer.
+	const size_t QUEUE_ROWS = 8;
+	std::vector<std::unique_ptr<RowQueue>> queues;
+	for (size_t i = 0; i <= stages.size(); ++i) {
+		queues.emplace_back(new RowQueue(QUEUE_ROWS));
+	}
+
+	std::atomic<bool> readFailed(false);
+	std::vector<std::thread> threads;
+	threads.emplace_back([&] {
+		std::vector<unsigned char> bytes;
+		for (int y = 0; y < header.height; ++y) {
+			Row row(header.width * 3);
+			if (!readPpmRow(infile.rdbuf(), header, row, bytes)) {
+				readFailed = true;
+				break;
+			}
+			queues[0]->push(std::move(row));
+		}
+		queues[0]->close();
+	});
+	for (size_t i = 0; i < stages.size(); ++i) {
+		threads.emplace_back([&, i] {
+			Row row;
+			while (queues[i]->pop(row)) {
+				stages[i]->process(row, *queues[i + 1]);
+			}
+			stages[i]->finish(*queues[i + 1]);
+			queues[i + 1]->close();
+		});
+	}
+
+	//Write ppm header, at the same maxval as the input
+	int maxValue = header.maxValue;
+	outfile << (header.binary ? "P6" : "P3") << "\n" << width << " " << height << "\n" << maxValue << "\n";
+
+	//Write the pixel data as it comes out of the last stage. 8-bit output has its own fast kernel;
+	//anything else goes through ints, written as two big-endian bytes per sample in P6 above 255.
+	int count = width * 3;
+	int sampleBytes = maxValue > 255 ? 2 : 1;
+	std::vector<unsigned char> bytes(static_cast<size_t>(count) * sampleBytes);
+	std::vector<int> samples(count);
+	std::string text;
+	Row row;
+	int rowsWritten = 0;
+	while (queues.back()->pop(row)) {
+		if (maxValue == 255) {
+			rowToBytes(row.data(), bytes.data(), count);
+			if (!header.binary) {
+				std::copy(bytes.begin(), bytes.end(), samples.begin());
+			}
+		} else {
+			rowToSamples(row.data(), samples.data(), count, maxValue);
+			for (int i = 0; i < count; ++i) {
+				if (sampleBytes == 2) {
+					bytes[2 * i] = static_cast<unsigned char>(samples[i] >> 8);
+					bytes[2 * i + 1] = static_cast<unsigned char>(samples[i] & 0xFF);
+				} else {
+					bytes[i] = static_cast<unsigned char>(samples[i]);
+				}
+			}
+		}
+		if (header.binary) {
+			outfile.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+		} else {
+			text.clear();
+			for (int value : samples) {
+				text += std::to_string(value);
+				text += ' ';
+			}
+			text += '\n';
+			outfile << text;
+		}
+		rowsWritten++;
+	}
+
+	for (auto& thread : threads) {
+		thread.join();
+	}
+
+	// The header went out before the input was fully read, so don't leave a partial image behind.
+	if (readFailed) {
+		std::cerr << "Error, " << inputPath << " ended early or has bad pixel data" << std::endl;
+		outfile.close();
+		std::remove(outputPath.c_str());
+		return 1;
+	}
+	if (rowsWritten != height || !outfile) {
+		std::cerr << "Error, could not write all of " << outputPath << std::endl;
+		outfile.close();
+		std::remove(outputPath.c_str());
+		return 1;
+	}
+	std::cout << "Wrote " << outputPath << " (" << width << "x" << height << ")" << std::endl;
+	return 0;
+}
 
 int main(int argc, char* argv[]) {
+	if (argc >= 2 && std::string(argv[1]) == "--pipeline") {
+		if (argc < 5) {
+			std::cerr << "Usage: " << argv[0] << " --pipeline <input.ppm> <output.ppm> <operation>..." << std::endl;
+			std::cerr << "Operations: blur:<sigma> resize:<width>x<height> tint:<RRGGBB>[:<amount>] crop:<x>,<y>,<width>,<height>" << std::endl;
+			return 1;
+		}
+		return runPipeline(argv[2], argv[3], std::vector<std::string>(argv + 4, argv + argc));
+	}
+
 	if (argc < 4) {
 		std::cerr << "Usage: " << argv[0] << " <width> <height> <color>" << std::endl;
+		std::cerr << "       " << argv[0] << " --pipeline <input.ppm> <output.ppm> <operation>..." << std::endl;
 		return 1;
 	}
 
@@ -23,18 +670,7 @@ int main(int argc, char* argv[]) {
 
 	std::ofstream outfile("output.ppm");
 
-	//Write ppm header
-	outfile << "P3" << std::endl;
-	outfile << width << " " << height << std::endl;
-	outfile << "255" << std::endl;
-
-	//Write the pixel data
-	for (int y = 0; y < height; ++y) {
-		for (int x = 0; x < height; ++x) {
-			outfile << r << " " << g << " " << b << " ";
-		}
-		outfile << std::endl;
-	}
+	writeImage(outfile, width, height, r, g, b);
 
 	outfile.close();
 
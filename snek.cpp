@@ -4,6 +4,9 @@
 #include <thread>
 #include <chrono>
 #include <cmath>
+#include <csignal>
+
+#include "tick-profiler.h"
 
 // ANSI escape codes for terminal manipulation
 // These codes are a standard way to control the cursor and colors in a Unix terminal.
@@ -46,16 +49,18 @@ void clearScreen() {
     std::cout << CLEAR_SCREEN << CURSOR_HOME;
 }
 
-// Function to draw the game world, including the snake and food.
-void drawWorld(const std::vector<std::vector<char>>& world, const Point& snakePos) {
-    clearScreen(); // Always clear the screen before redrawing to prevent flickering
+// Function to render the game world, including the snake and food, into a string.
+// Building the whole frame first lets us write it to the terminal in one go.
+std::string renderWorld(const std::vector<std::vector<char>>& world, const Point& snakePos) {
+    // Always clear the screen before redrawing to prevent flickering
+    std::string frame = std::string(CLEAR_SCREEN) + CURSOR_HOME;
 
     // Print the border of the world.
-    std::cout << "--------------------" << std::endl;
+    frame += "--------------------\n";
 
     // Loop through each row and column of our 2D world array.
     for (size_t y = 0; y < world.size(); ++y) {
-        std::cout << "| "; // Left border
+        frame += "| "; // Left border
 
         // Loop through each character in the row.
         for (size_t x = 0; x < world[y].size(); ++x) {
@@ -68,7 +73,9 @@ void drawWorld(const std::vector<std::vector<char>>& world, const Point& snakePo
                 // Get the corresponding character from our SNAKE_BODY array.
                 char snakeChar = SNAKE_BODY[y - snakePos.y][x - snakePos.x];
                 if (snakeChar != ' ') {
-                    std::cout << GREEN_TEXT << snakeChar << RESET_COLOR;
+                    frame += GREEN_TEXT;
+                    frame += snakeChar;
+                    frame += RESET_COLOR;
                     isSnake = true;
                 }
             }
@@ -76,16 +83,24 @@ void drawWorld(const std::vector<std::vector<char>>& world, const Point& snakePo
             if (!isSnake) {
                 if (world[y][x] == FOOD_CHAR) {
                     // If the character is food, make it red.
-                    std::cout << RED_TEXT << world[y][x] << RESET_COLOR;
+                    frame += RED_TEXT;
+                    frame += world[y][x];
+                    frame += RESET_COLOR;
                 } else {
-                    std::cout << world[y][x];
+                    frame += world[y][x];
                 }
             }
         }
-        std::cout << " |" << std::endl; // Right border
+        frame += " |\n"; // Right border
     }
-    std::cout << "--------------------" << std::endl;
-    std::cout << "Snake position: (" << snakePos.x << ", " << snakePos.y << ")" << std::endl;
+    frame += "--------------------\n";
+    frame += "Snake position: (" + std::to_string(snakePos.x) + ", " + std::to_string(snakePos.y) + ")\n";
+    return frame;
+}
+
+// Function to draw the game world to the terminal.
+void drawWorld(const std::vector<std::vector<char>>& world, const Point& snakePos) {
+    std::cout << renderWorld(world, snakePos) << std::flush;
 }
 
 // Function to find the nearest food item to the snake.
@@ -136,7 +151,16 @@ Point getNextMove(const Point& snakePos, const Point& foodPos) {
     return nextPos;
 }
 
+// Set from the Ctrl-C handler so the game loop can stop and write its timing stats.
+volatile std::sig_atomic_t g_quitRequested = 0;
+
+void handleQuitSignal(int) {
+    g_quitRequested = 1;
+}
+
 int main() {
+    std::signal(SIGINT, handleQuitSignal);
+
     // Define the dimensions of our game world.
     const int WORLD_WIDTH = 20;
     const int WORLD_HEIGHT = 10;
@@ -155,35 +179,62 @@ int main() {
     // Set the initial position of the snake.
     Point snakePosition = {1, 1};
 
-    // The main game loop. This runs indefinitely until the user closes the program.
-    while (true) {
+    enum { PHASE_FOOD_SEARCH, PHASE_MOVE, PHASE_EAT, PHASE_RENDER, PHASE_OUTPUT_WRITE };
+    TickProfiler profiler({"food_search", "move", "eat", "render", "output_write"});
+
+    // Sleep to absolute deadlines, so the time spent on each tick does not slow the game down.
+    FramePacer pacer(std::chrono::milliseconds(200));
+
+    // The main game loop. This runs until the user presses Ctrl-C.
+    while (!g_quitRequested) {
         // Find the nearest food item for the snake to chase.
-        Point foodLocation = findNearestFood(world, snakePosition);
-
-        // Calculate the snake's next position based on the food location.
-        Point nextPosition = getNextMove(snakePosition, foodLocation);
-
-        // Update the snake's position.
-        snakePosition = nextPosition;
-
-        // Check if the snake has "eaten" the food.
-        // We'll consider it eaten if the snake's head (top-left corner) is on the food's location.
-        // This is a simple collision detection. We can make it more sophisticated later.
-        if (foodLocation.x != -1 && 
-            snakePosition.x == foodLocation.x && 
-            snakePosition.y == foodLocation.y) {
-            
-            // Remove the food from the world.
-            world[foodLocation.y][foodLocation.x] = ' ';
-            std::cout << "The snake ate the food! It will now find the next one." << std::endl;
+        Point foodLocation;
+        {
+            ScopedPhaseTimer timer(profiler, PHASE_FOOD_SEARCH);
+            foodLocation = findNearestFood(world, snakePosition);
+        }
+
+        {
+            ScopedPhaseTimer timer(profiler, PHASE_MOVE);
+            // Calculate the snake's next position based on the food location.
+            Point nextPosition = getNextMove(snakePosition, foodLocation);
+
+            // Update the snake's position.
+            snakePosition = nextPosition;
+        }
+
+        {
+            ScopedPhaseTimer timer(profiler, PHASE_EAT);
+            // Check if the snake has "eaten" the food.
+            // We'll consider it eaten if the snake's head (top-left corner) is on the food's location.
+            // This is a simple collision detection. We can make it more sophisticated later.
+            if (foodLocation.x != -1 && 
+                snakePosition.x == foodLocation.x && 
+                snakePosition.y == foodLocation.y) {
+                
+                // Remove the food from the world.
+                world[foodLocation.y][foodLocation.x] = ' ';
+            }
         }
 
-        // Draw the updated world.
-        drawWorld(world, snakePosition);
+        // Draw the updated world, with the timings underneath.
+        std::string frame;
+        {
+            ScopedPhaseTimer timer(profiler, PHASE_RENDER);
+            frame = renderWorld(world, snakePosition) + profiler.summary() +
+                    "Missed frame deadlines: " + std::to_string(pacer.missedDeadlines()) + "\n";
+        }
+        {
+            ScopedPhaseTimer timer(profiler, PHASE_OUTPUT_WRITE);
+            std::cout << frame << std::flush;
+        }
 
-        // Pause for a short duration to control the speed of the animation.
-        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        // Wait for the next frame to keep the speed of the animation steady.
+        pacer.wait();
     }
 
+    // Save the timings so runs can be compared.
+    writeStats(profiler, "snek-stats.json");
+
     return 0;
 }
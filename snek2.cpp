@@ -5,6 +5,16 @@
 #include <chrono>
 #include <cmath>
 #include <random>
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <csignal>
+
+#include "tick-profiler.h"
 
 // ANSI escape codes for terminal manipulation
 // These codes are a standard way to control the cursor and colors in a Unix terminal.
@@ -31,10 +41,12 @@ void clearScreen() {
     std::cout << CLEAR_SCREEN << CURSOR_HOME;
 }
 
-// Function to draw the game world, including the snake and food.
+// Function to render the game world, including the snake and food, into a string.
 // Now takes a vector of points to represent the entire snake body.
-void drawWorld(const std::vector<std::vector<char>>& world, const std::vector<Point>& snakeBody) {
-    clearScreen(); // Always clear the screen before redrawing to prevent flickering
+// Building the whole frame first lets us write it to the terminal in one go.
+std::string renderWorld(const std::vector<std::vector<char>>& world, const std::vector<Point>& snakeBody) {
+    // Always clear the screen before redrawing to prevent flickering
+    std::string frame = std::string(CLEAR_SCREEN) + CURSOR_HOME;
 
     // Create a temporary world to draw the snake on top of the food.
     std::vector<std::vector<char>> displayWorld = world;
@@ -51,24 +63,32 @@ void drawWorld(const std::vector<std::vector<char>>& world, const std::vector<Po
     }
 
     // Print the border and the contents of the display world.
-    std::cout << "--------------------" << std::endl;
+    frame += "--------------------\n";
     for (size_t y = 0; y < displayWorld.size(); ++y) {
-        std::cout << "| "; // Left border
+        frame += "| "; // Left border
         for (size_t x = 0; x < displayWorld[y].size(); ++x) {
             if (displayWorld[y][x] == FOOD_CHAR) {
-                std::cout << RED_TEXT << displayWorld[y][x] << RESET_COLOR;
-            } else if (displayWorld[y][x] == SNAKE_HEAD_CHAR) {
-                std::cout << GREEN_TEXT << displayWorld[y][x] << RESET_COLOR;
-            } else if (displayWorld[y][x] == SNAKE_BODY_CHAR) {
-                std::cout << GREEN_TEXT << displayWorld[y][x] << RESET_COLOR;
+                frame += RED_TEXT;
+                frame += displayWorld[y][x];
+                frame += RESET_COLOR;
+            } else if (displayWorld[y][x] == SNAKE_HEAD_CHAR || displayWorld[y][x] == SNAKE_BODY_CHAR) {
+                frame += GREEN_TEXT;
+                frame += displayWorld[y][x];
+                frame += RESET_COLOR;
             } else {
-                std::cout << displayWorld[y][x];
+                frame += displayWorld[y][x];
             }
         }
-        std::cout << " |" << std::endl; // Right border
+        frame += " |\n"; // Right border
     }
-    std::cout << "--------------------" << std::endl;
-    std::cout << "Snake length: " << snakeBody.size() << std::endl;
+    frame += "--------------------\n";
+    frame += "Snake length: " + std::to_string(snakeBody.size()) + "\n";
+    return frame;
+}
+
+// Function to draw the game world to the terminal.
+void drawWorld(const std::vector<std::vector<char>>& world, const std::vector<Point>& snakeBody) {
+    std::cout << renderWorld(world, snakeBody) << std::flush;
 }
 
 // Function to find the nearest food item to the snake's head.
@@ -142,7 +162,542 @@ void placeFoodRandomly(std::vector<std::vector<char>>& world, const std::vector<
     }
 }
 
-int main() {
+// Set from the Ctrl-C handler so the game loops can stop and write their timing stats.
+volatile std::sig_atomic_t g_quitRequested = 0;
+
+void handleQuitSignal(int) {
+    g_quitRequested = 1;
+}
+
+// --- Arena mode: hundreds to thousands of AI snakes on one large board ---
+
+const int ARENA_SIGHT = 8;             // How far (Manhattan distance) an arena snake looks for food.
+const int ARENA_MAX_LENGTH = 64;       // Ring capacity of each snake in the shared body pool.
+const int ARENA_CELLS_PER_SNAKE = 100; // Board area per snake, used to size the grid.
+const int ARENA_FOOD_PER_SNAKE = 2;    // The board is topped up to this much food per snake.
+const int ARENA_VIEW_WIDTH = 60;       // Size of the corner of the board drawn on screen.
+const int ARENA_VIEW_HEIGHT = 20;
+const int EMPTY_CELL = -1;
+
+// All arena snakes, stored structure-of-arrays so each phase only touches the fields it needs.
+// Snake i owns the slice [i * ARENA_MAX_LENGTH, (i + 1) * ARENA_MAX_LENGTH) of the body pool
+// and uses it as a ring: ringHead[i] is the slot of the head, older segments sit behind it.
+struct Arena {
+    int width;
+    int height;
+    int snakeCount;
+
+    // Per-snake state.
+    std::vector<int> headX;
+    std::vector<int> headY;
+    std::vector<int> length;
+    std::vector<int> ringHead;
+    std::vector<char> alive;
+    std::vector<char> crashed;
+
+    // Moves planned by the parallel phase, one per snake.
+    std::vector<int> nextX;
+    std::vector<int> nextY;
+
+    // Shared body pool.
+    std::vector<int> bodyX;
+    std::vector<int> bodyY;
+
+    // The board: which snake occupies each cell (EMPTY_CELL if none) and where the food is.
+    std::vector<int> owner;
+    std::vector<char> food;
+    int foodCount;
+
+    // How many heads want each cell this tick. The counts are tagged with the tick that
+    // wrote them, so the arrays never need clearing.
+    std::vector<uint32_t> claimTick;
+    std::vector<int> claimCount;
+
+    uint32_t tick;
+    std::mt19937 rng;
+};
+
+// A small fork-join pool: run() splits [0, count) into one contiguous chunk per thread,
+// runs the chunks in parallel (the calling thread takes the first one) and waits for all of them.
+class WorkerPool {
+public:
+    explicit WorkerPool(int threads) : threadCount(std::max(1, threads)) {
+        for (int t = 1; t < threadCount; ++t) {
+            workers.emplace_back(&WorkerPool::workerLoop, this, t);
+        }
+    }
+
+    ~WorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    void run(int count, const std::function<void(int, int)>& fn) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            job = &fn;
+            jobCount = count;
+            pending = threadCount - 1;
+            ++generation;
+        }
+        wake.notify_all();
+        runChunk(0);
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this] { return pending == 0; });
+    }
+
+private:
+    void runChunk(int t) {
+        int begin = static_cast<int>(static_cast<long long>(jobCount) * t / threadCount);
+        int end = static_cast<int>(static_cast<long long>(jobCount) * (t + 1) / threadCount);
+        (*job)(begin, end);
+    }
+
+    void workerLoop(int t) {
+        unsigned seen = 0;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [&] { return stopping || generation != seen; });
+                if (stopping) {
+                    return;
+                }
+                seen = generation;
+            }
+            runChunk(t);
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--pending == 0) {
+                done.notify_one();
+            }
+        }
+    }
+
+    int threadCount;
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    const std::function<void(int, int)>* job = nullptr;
+    int jobCount = 0;
+    int pending = 0;
+    unsigned generation = 0;
+    bool stopping = false;
+};
+
+// Index of the k-th segment of snake i (k = 0 is the head) in the shared body pool.
+int arenaSegment(const Arena& arena, int i, int k) {
+    return i * ARENA_MAX_LENGTH + (arena.ringHead[i] - k + ARENA_MAX_LENGTH) % ARENA_MAX_LENGTH;
+}
+
+// Place snake i, one segment long, on a random empty cell.
+void spawnArenaSnake(Arena& arena, int i) {
+    std::uniform_int_distribution<> disX(0, arena.width - 1);
+    std::uniform_int_distribution<> disY(0, arena.height - 1);
+
+    for (int attempt = 0; attempt < 100; ++attempt) {
+        int x = disX(arena.rng);
+        int y = disY(arena.rng);
+        int cell = y * arena.width + x;
+        if (arena.owner[cell] == EMPTY_CELL && !arena.food[cell]) {
+            arena.headX[i] = x;
+            arena.headY[i] = y;
+            arena.length[i] = 1;
+            arena.ringHead[i] = 0;
+            arena.bodyX[i * ARENA_MAX_LENGTH] = x;
+            arena.bodyY[i * ARENA_MAX_LENGTH] = y;
+            arena.owner[cell] = i;
+            arena.alive[i] = 1;
+            return;
+        }
+    }
+    // The board is too crowded right now; we try again next tick.
+    arena.alive[i] = 0;
+}
+
+// Place food on random empty cells until the board has its target amount.
+void topUpArenaFood(Arena& arena) {
+    std::uniform_int_distribution<> disX(0, arena.width - 1);
+    std::uniform_int_distribution<> disY(0, arena.height - 1);
+
+    int target = arena.snakeCount * ARENA_FOOD_PER_SNAKE;
+    for (int attempt = 0; arena.foodCount < target && attempt < 4 * target; ++attempt) {
+        int cell = disY(arena.rng) * arena.width + disX(arena.rng);
+        if (arena.owner[cell] == EMPTY_CELL && !arena.food[cell]) {
+            arena.food[cell] = 1;
+            arena.foodCount++;
+        }
+    }
+}
+
+// Create an arena sized for the given number of snakes. The seed makes runs reproducible.
+Arena createArena(int snakeCount, unsigned seed) {
+    Arena arena;
+    int side = static_cast<int>(std::ceil(std::sqrt(static_cast<double>(snakeCount) * ARENA_CELLS_PER_SNAKE)));
+    arena.width = std::max(side, ARENA_VIEW_WIDTH);
+    arena.height = std::max(side, ARENA_VIEW_HEIGHT);
+    arena.snakeCount = snakeCount;
+
+    arena.headX.assign(snakeCount, 0);
+    arena.headY.assign(snakeCount, 0);
+    arena.length.assign(snakeCount, 0);
+    arena.ringHead.assign(snakeCount, 0);
+    arena.alive.assign(snakeCount, 0);
+    arena.crashed.assign(snakeCount, 0);
+    arena.nextX.assign(snakeCount, 0);
+    arena.nextY.assign(snakeCount, 0);
+    arena.bodyX.assign(static_cast<size_t>(snakeCount) * ARENA_MAX_LENGTH, 0);
+    arena.bodyY.assign(static_cast<size_t>(snakeCount) * ARENA_MAX_LENGTH, 0);
+
+    size_t cells = static_cast<size_t>(arena.width) * arena.height;
+    arena.owner.assign(cells, EMPTY_CELL);
+    arena.food.assign(cells, 0);
+    arena.foodCount = 0;
+    arena.claimTick.assign(cells, 0);
+    arena.claimCount.assign(cells, 0);
+
+    arena.tick = 0;
+    arena.rng.seed(seed);
+
+    for (int i = 0; i < snakeCount; ++i) {
+        spawnArenaSnake(arena, i);
+    }
+    topUpArenaFood(arena);
+    return arena;
+}
+
+// Cheap integer hash, used to pick a wandering direction without any shared random state,
+// so a snake's plan is the same no matter which thread computes it.
+uint32_t arenaHash(uint32_t a, uint32_t b) {
+    uint32_t h = a * 0x9E3779B1u ^ (b + 0x7F4A7C15u);
+    h ^= h >> 15;
+    h *= 0x2C1B3C6Du;
+    h ^= h >> 12;
+    h *= 0x297A2D39u;
+    h ^= h >> 15;
+    return h;
+}
+
+// Check whether (x, y) is on the board and nobody is standing there.
+bool arenaCellFree(const Arena& arena, int x, int y) {
+    return x >= 0 && x < arena.width && y >= 0 && y < arena.height &&
+           arena.owner[y * arena.width + x] == EMPTY_CELL;
+}
+
+// Find the nearest food within ARENA_SIGHT of (x, y). We scan rings of growing Manhattan
+// distance, so the search stops at the closest food instead of looking at the whole board.
+Point findNearestArenaFood(const Arena& arena, int x, int y) {
+    for (int d = 1; d <= ARENA_SIGHT; ++d) {
+        for (int dx = -d; dx <= d; ++dx) {
+            int fx = x + dx;
+            if (fx < 0 || fx >= arena.width) {
+                continue;
+            }
+            int dy = d - std::abs(dx);
+            if (y - dy >= 0 && arena.food[(y - dy) * arena.width + fx]) {
+                return {fx, y - dy};
+            }
+            if (dy != 0 && y + dy < arena.height && arena.food[(y + dy) * arena.width + fx]) {
+                return {fx, y + dy};
+            }
+        }
+    }
+    return {-1, -1};
+}
+
+// Work out where snake i wants to go. This only reads the state from the start of the tick
+// and only writes nextX[i]/nextY[i], so all snakes can be planned in parallel.
+void planArenaMove(Arena& arena, int i) {
+    const int dirX[4] = {1, -1, 0, 0};
+    const int dirY[4] = {0, 0, 1, -1};
+
+    int x = arena.headX[i];
+    int y = arena.headY[i];
+    uint32_t h = arenaHash(static_cast<uint32_t>(i), arena.tick);
+
+    // Head for the nearest food with the same greedy step as the single snake,
+    // or wander in a random direction if no food is in sight.
+    int first = h & 3;
+    Point foodPos = findNearestArenaFood(arena, x, y);
+    if (foodPos.x != -1) {
+        Point step = getNextMove({x, y}, foodPos);
+        first = step.x > x ? 0 : step.x < x ? 1 : step.y > y ? 2 : 3;
+    }
+
+    // Try the preferred direction first, then the others, skipping blocked cells.
+    // An odd stride visits all four directions.
+    int stride = (h & 4) ? 1 : 3;
+    for (int n = 0; n < 4; ++n) {
+        int dir = (first + n * stride) & 3;
+        if (arenaCellFree(arena, x + dirX[dir], y + dirY[dir])) {
+            arena.nextX[i] = x + dirX[dir];
+            arena.nextY[i] = y + dirY[dir];
+            return;
+        }
+    }
+
+    // Boxed in: staying put means running into ourselves.
+    arena.nextX[i] = x;
+    arena.nextY[i] = y;
+}
+
+// Resolve conflicts between the planned moves and apply them. This runs on one thread,
+// and every rule treats all snakes the same way, so the result does not depend on how
+// planning was split across threads:
+//  - moving off the board or into any occupied cell (tails included) kills the snake;
+//  - if several heads move into the same cell, all of them die.
+// Dead snakes turn into food and respawn somewhere else.
+void resolveArenaTick(Arena& arena) {
+    arena.tick++;
+
+    // Count how many heads want each cell, and catch snakes that hit a wall or a body.
+    for (int i = 0; i < arena.snakeCount; ++i) {
+        if (!arena.alive[i]) {
+            continue;
+        }
+        arena.crashed[i] = !arenaCellFree(arena, arena.nextX[i], arena.nextY[i]);
+        if (!arena.crashed[i]) {
+            int cell = arena.nextY[i] * arena.width + arena.nextX[i];
+            if (arena.claimTick[cell] != arena.tick) {
+                arena.claimTick[cell] = arena.tick;
+                arena.claimCount[cell] = 0;
+            }
+            arena.claimCount[cell]++;
+        }
+    }
+
+    // Head-to-head collisions.
+    for (int i = 0; i < arena.snakeCount; ++i) {
+        if (arena.alive[i] && !arena.crashed[i] &&
+            arena.claimCount[arena.nextY[i] * arena.width + arena.nextX[i]] > 1) {
+            arena.crashed[i] = 1;
+        }
+    }
+
+    // Crashed snakes leave food behind where their body was.
+    for (int i = 0; i < arena.snakeCount; ++i) {
+        if (!arena.alive[i] || !arena.crashed[i]) {
+            continue;
+        }
+        for (int k = 0; k < arena.length[i]; ++k) {
+            int segment = arenaSegment(arena, i, k);
+            int cell = arena.bodyY[segment] * arena.width + arena.bodyX[segment];
+            arena.owner[cell] = EMPTY_CELL;
+            arena.food[cell] = 1;
+            arena.foodCount++;
+        }
+        arena.alive[i] = 0;
+    }
+
+    // Move the survivors. Their target cells were empty at the start of the tick,
+    // so the order in which we move them does not matter.
+    for (int i = 0; i < arena.snakeCount; ++i) {
+        if (!arena.alive[i]) {
+            continue;
+        }
+        int cell = arena.nextY[i] * arena.width + arena.nextX[i];
+        bool ateFood = arena.food[cell];
+        if (ateFood) {
+            arena.food[cell] = 0;
+            arena.foodCount--;
+        }
+
+        if (ateFood && arena.length[i] < ARENA_MAX_LENGTH) {
+            arena.length[i]++;
+        } else {
+            // Free the tail cell; its ring slot gets reused by the new head if the ring is full.
+            int tail = arenaSegment(arena, i, arena.length[i] - 1);
+            arena.owner[arena.bodyY[tail] * arena.width + arena.bodyX[tail]] = EMPTY_CELL;
+        }
+
+        arena.ringHead[i] = (arena.ringHead[i] + 1) % ARENA_MAX_LENGTH;
+        int head = arenaSegment(arena, i, 0);
+        arena.bodyX[head] = arena.nextX[i];
+        arena.bodyY[head] = arena.nextY[i];
+        arena.headX[i] = arena.nextX[i];
+        arena.headY[i] = arena.nextY[i];
+        arena.owner[cell] = i;
+    }
+
+    for (int i = 0; i < arena.snakeCount; ++i) {
+        if (!arena.alive[i]) {
+            spawnArenaSnake(arena, i);
+        }
+    }
+    topUpArenaFood(arena);
+}
+
+// Plan the moves of all live snakes, split across the pool's threads.
+void planArena(Arena& arena, WorkerPool& pool) {
+    pool.run(arena.snakeCount, [&arena](int begin, int end) {
+        for (int i = begin; i < end; ++i) {
+            if (arena.alive[i]) {
+                planArenaMove(arena, i);
+            }
+        }
+    });
+}
+
+// Advance the arena by one tick: plan every move in parallel, then resolve them in order.
+void stepArena(Arena& arena, WorkerPool& pool) {
+    planArena(arena, pool);
+    resolveArenaTick(arena);
+}
+
+// Fingerprint of the arena state, used to check that runs with different thread counts agree.
+uint64_t arenaChecksum(const Arena& arena) {
+    uint64_t hash = 1469598103934665603ull;
+    auto mix = [&hash](uint64_t value) {
+        hash ^= value;
+        hash *= 1099511628211ull;
+    };
+    for (int i = 0; i < arena.snakeCount; ++i) {
+        mix(static_cast<uint64_t>(arena.headX[i]));
+        mix(static_cast<uint64_t>(arena.headY[i]));
+        mix(static_cast<uint64_t>(arena.length[i]));
+        mix(static_cast<uint64_t>(arena.alive[i]));
+    }
+    mix(static_cast<uint64_t>(arena.foodCount));
+    return hash;
+}
+
+// Render the top-left corner of the arena; the whole board does not fit in a terminal.
+std::string renderArena(const Arena& arena) {
+    std::string frame = std::string(CLEAR_SCREEN) + CURSOR_HOME;
+
+    int viewWidth = std::min(arena.width, ARENA_VIEW_WIDTH);
+    int viewHeight = std::min(arena.height, ARENA_VIEW_HEIGHT);
+    std::string border(viewWidth + 4, '-');
+
+    frame += border + "\n";
+    for (int y = 0; y < viewHeight; ++y) {
+        frame += "| "; // Left border
+        for (int x = 0; x < viewWidth; ++x) {
+            int cell = y * arena.width + x;
+            int snake = arena.owner[cell];
+            if (snake != EMPTY_CELL) {
+                bool isHead = arena.headX[snake] == x && arena.headY[snake] == y;
+                frame += GREEN_TEXT;
+                frame += isHead ? SNAKE_HEAD_CHAR : SNAKE_BODY_CHAR;
+                frame += RESET_COLOR;
+            } else if (arena.food[cell]) {
+                frame += RED_TEXT;
+                frame += FOOD_CHAR;
+                frame += RESET_COLOR;
+            } else {
+                frame += ' ';
+            }
+        }
+        frame += " |\n"; // Right border
+    }
+    frame += border + "\n";
+
+    int aliveCount = 0;
+    int longest = 0;
+    for (int i = 0; i < arena.snakeCount; ++i) {
+        if (arena.alive[i]) {
+            aliveCount++;
+            longest = std::max(longest, arena.length[i]);
+        }
+    }
+    frame += "Board: " + std::to_string(arena.width) + "x" + std::to_string(arena.height) +
+             " | Snakes alive: " + std::to_string(aliveCount) + "/" + std::to_string(arena.snakeCount) +
+             " | Longest: " + std::to_string(longest) +
+             " | Tick: " + std::to_string(arena.tick) + "\n";
+    return frame;
+}
+
+// Run the arena with the given number of snakes and planning threads until Ctrl-C.
+void runArena(int snakeCount, int threadCount) {
+    enum { PHASE_PLAN, PHASE_RESOLVE, PHASE_RENDER, PHASE_OUTPUT_WRITE };
+    TickProfiler profiler({"plan", "resolve", "render", "output_write"});
+    FramePacer pacer(std::chrono::milliseconds(200));
+
+    Arena arena = createArena(snakeCount, std::random_device{}());
+    WorkerPool pool(threadCount);
+
+    while (!g_quitRequested) {
+        {
+            ScopedPhaseTimer timer(profiler, PHASE_PLAN);
+            planArena(arena, pool);
+        }
+        {
+            ScopedPhaseTimer timer(profiler, PHASE_RESOLVE);
+            resolveArenaTick(arena);
+        }
+
+        std::string frame;
+        {
+            ScopedPhaseTimer timer(profiler, PHASE_RENDER);
+            frame = renderArena(arena) + profiler.summary() +
+                    "Missed frame deadlines: " + std::to_string(pacer.missedDeadlines()) + "\n";
+        }
+        {
+            ScopedPhaseTimer timer(profiler, PHASE_OUTPUT_WRITE);
+            std::cout << frame << std::flush;
+        }
+
+        pacer.wait();
+    }
+
+    writeStats(profiler, "snek2-arena-stats.json");
+}
+
+// Measure ticks per second for a range of snake and thread counts. Every run uses the same
+// seed and tick count, so the checksums in a row must match whatever the thread count.
+void runArenaBenchmark() {
+    const int snakeCounts[] = {250, 500, 1000, 2000, 4000};
+    const int ticks = 200;
+
+    std::vector<int> threadCounts = {1, 2, 4, 8};
+    int hardwareThreads = static_cast<int>(std::thread::hardware_concurrency());
+    if (hardwareThreads > 8) {
+        threadCounts.push_back(hardwareThreads);
+    }
+
+    std::cout << "snakes  threads  board      ticks/sec  checksum" << std::endl;
+    for (int snakeCount : snakeCounts) {
+        for (int threadCount : threadCounts) {
+            Arena arena = createArena(snakeCount, 12345);
+            WorkerPool pool(threadCount);
+
+            auto start = std::chrono::steady_clock::now();
+            for (int t = 0; t < ticks; ++t) {
+                stepArena(arena, pool);
+            }
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+            std::string board = std::to_string(arena.width) + "x" + std::to_string(arena.height);
+            std::printf("%6d  %7d  %-9s  %9.1f  %016llx\n", snakeCount, threadCount, board.c_str(),
+                        ticks / elapsed.count(), static_cast<unsigned long long>(arenaChecksum(arena)));
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    std::signal(SIGINT, handleQuitSignal);
+
+    std::string mode = argc > 1 ? argv[1] : "";
+    if (mode == "--arena") {
+        int snakeCount = argc > 2 ? std::stoi(argv[2]) : 500;
+        int threadCount = argc > 3 ? std::stoi(argv[3]) : static_cast<int>(std::thread::hardware_concurrency());
+        runArena(std::max(1, snakeCount), std::max(1, threadCount));
+        return 0;
+    }
+    if (mode == "--arena-bench") {
+        runArenaBenchmark();
+        return 0;
+    }
+    if (!mode.empty()) {
+        std::cerr << "Usage: " << argv[0] << " [--arena [snakes] [threads] | --arena-bench]" << std::endl;
+        return 1;
+    }
+
     // Define the dimensions of our game world.
     const int WORLD_WIDTH = 20;
     const int WORLD_HEIGHT = 10;
@@ -156,39 +711,66 @@ int main() {
     // Place some "food" characters randomly in the world.
     placeFoodRandomly(world, snakeBody);
 
-    // The main game loop.
-    while (true) {
+    enum { PHASE_FOOD_SEARCH, PHASE_MOVE, PHASE_GROW, PHASE_RENDER, PHASE_OUTPUT_WRITE };
+    TickProfiler profiler({"food_search", "move", "grow", "render", "output_write"});
+
+    // Sleep to absolute deadlines, so the time spent on each tick does not slow the game down.
+    FramePacer pacer(std::chrono::milliseconds(200));
+
+    // The main game loop, until Ctrl-C.
+    while (!g_quitRequested) {
         // Get the current position of the snake's head.
         Point currentHead = snakeBody.front();
         
         // Find the nearest food item for the snake to chase.
-        Point foodLocation = findNearestFood(world, currentHead);
+        Point foodLocation;
+        {
+            ScopedPhaseTimer timer(profiler, PHASE_FOOD_SEARCH);
+            foodLocation = findNearestFood(world, currentHead);
+        }
 
-        // Calculate the snake's next position based on the food location.
-        Point nextHeadPosition = getNextMove(currentHead, foodLocation);
+        Point nextHeadPosition;
+        {
+            ScopedPhaseTimer timer(profiler, PHASE_MOVE);
+            // Calculate the snake's next position based on the food location.
+            nextHeadPosition = getNextMove(currentHead, foodLocation);
 
-        // Add the new head position to the front of the snake's body vector.
-        snakeBody.insert(snakeBody.begin(), nextHeadPosition);
+            // Add the new head position to the front of the snake's body vector.
+            snakeBody.insert(snakeBody.begin(), nextHeadPosition);
+        }
 
-        // Check if the snake has "eaten" the food.
-        bool ateFood = (foodLocation.x != -1 && nextHeadPosition.x == foodLocation.x && nextHeadPosition.y == foodLocation.y);
-        
-        if (ateFood) {
-            // If the snake ate food, remove the food from the world.
-            world[foodLocation.y][foodLocation.x] = ' ';
-            // Don't remove the tail, so the snake grows.
-            std::cout << "The snake ate the food! It will now find the next one." << std::endl;
-        } else {
-            // If the snake didn't eat, remove the last segment of the tail.
-            snakeBody.pop_back();
+        {
+            ScopedPhaseTimer timer(profiler, PHASE_GROW);
+            // Check if the snake has "eaten" the food.
+            bool ateFood = (foodLocation.x != -1 && nextHeadPosition.x == foodLocation.x && nextHeadPosition.y == foodLocation.y);
+
+            if (ateFood) {
+                // If the snake ate food, remove the food from the world.
+                world[foodLocation.y][foodLocation.x] = ' ';
+                // Don't remove the tail, so the snake grows.
+            } else {
+                // If the snake didn't eat, remove the last segment of the tail.
+                snakeBody.pop_back();
+            }
         }
 
-        // Draw the updated world.
-        drawWorld(world, snakeBody);
+        // Draw the updated world, with the timings underneath.
+        std::string frame;
+        {
+            ScopedPhaseTimer timer(profiler, PHASE_RENDER);
+            frame = renderWorld(world, snakeBody) + profiler.summary() +
+                    "Missed frame deadlines: " + std::to_string(pacer.missedDeadlines()) + "\n";
+        }
+        {
+            ScopedPhaseTimer timer(profiler, PHASE_OUTPUT_WRITE);
+            std::cout << frame << std::flush;
+        }
 
-        // Pause for a short duration to control the speed of the animation.
-        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        // Wait for the next frame to keep the speed of the animation steady.
+        pacer.wait();
     }
 
+    writeStats(profiler, "snek2-stats.json");
+
     return 0;
 }
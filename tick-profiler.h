@@ -0,0 +1,185 @@
+#ifndef TICK_PROFILER_H
+#define TICK_PROFILER_H
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Lightweight timing for the snek game loops.
+// A TickProfiler keeps one fixed-size histogram per named phase of a tick (food search,
+// move, render, ...). Phases are timed with a ScopedPhaseTimer, and the FramePacer
+// sleeps to absolute deadlines so the frame period does not drift by the work time.
+
+// Histogram of durations in nanoseconds. Buckets are log-linear: each power of two is split
+// into 8 sub-buckets, so a percentile read back from it is within about 6% of the real value.
+// The bucket array has a fixed size, so recording never allocates.
+class DurationHistogram {
+public:
+    static const int SUB_BUCKETS = 8;
+    static const int SUB_BUCKET_BITS = 3;
+    static const int BUCKET_COUNT = 40 * SUB_BUCKETS; // Enough for durations over half an hour.
+
+    DurationHistogram() : buckets(), total(0), largest(0) {}
+
+    void record(uint64_t nanoseconds) {
+        buckets[bucketFor(nanoseconds)]++;
+        total++;
+        if (nanoseconds > largest) {
+            largest = nanoseconds;
+        }
+    }
+
+    uint64_t count() const { return total; }
+    uint64_t max() const { return largest; }
+
+    // Duration below which the given fraction (0..1) of the samples fall.
+    uint64_t percentile(double fraction) const {
+        if (total == 0) {
+            return 0;
+        }
+        uint64_t rank = static_cast<uint64_t>(fraction * (total - 1)) + 1;
+        uint64_t seen = 0;
+        for (int i = 0; i < BUCKET_COUNT; ++i) {
+            seen += buckets[i];
+            if (seen >= rank) {
+                return bucketMiddle(i) < largest ? bucketMiddle(i) : largest;
+            }
+        }
+        return largest;
+    }
+
+private:
+    static int bucketFor(uint64_t value) {
+        if (value < SUB_BUCKETS) {
+            return static_cast<int>(value);
+        }
+        int topBit = 63 - __builtin_clzll(value);
+        int shift = topBit - SUB_BUCKET_BITS;
+        int index = (shift + 1) * SUB_BUCKETS + static_cast<int>((value >> shift) & (SUB_BUCKETS - 1));
+        return index < BUCKET_COUNT ? index : BUCKET_COUNT - 1;
+    }
+
+    static uint64_t bucketMiddle(int index) {
+        if (index < SUB_BUCKETS) {
+            return index;
+        }
+        int shift = index / SUB_BUCKETS - 1;
+        uint64_t low = static_cast<uint64_t>(SUB_BUCKETS + index % SUB_BUCKETS) << shift;
+        return low + ((1ull << shift) >> 1);
+    }
+
+    uint32_t buckets[BUCKET_COUNT];
+    uint64_t total;
+    uint64_t largest;
+};
+
+// Format a duration in nanoseconds for humans, e.g. "850ns", "12.3us" or "4.56ms".
+inline std::string formatDuration(uint64_t nanoseconds) {
+    char text[32];
+    if (nanoseconds < 1000) {
+        std::snprintf(text, sizeof(text), "%lluns", static_cast<unsigned long long>(nanoseconds));
+    } else if (nanoseconds < 1000000) {
+        std::snprintf(text, sizeof(text), "%.1fus", nanoseconds / 1e3);
+    } else {
+        std::snprintf(text, sizeof(text), "%.2fms", nanoseconds / 1e6);
+    }
+    return text;
+}
+
+// Per-phase timings for a game loop. Phases are identified by their index in the name list.
+class TickProfiler {
+public:
+    explicit TickProfiler(const std::vector<std::string>& phaseNames)
+        : names(phaseNames), histograms(phaseNames.size()) {}
+
+    void record(int phase, std::chrono::nanoseconds duration) {
+        histograms[phase].record(static_cast<uint64_t>(duration.count()));
+    }
+
+    // One line per phase with p50/p99, for showing under the game board.
+    std::string summary() const {
+        std::string text = "Tick timings (p50 / p99):\n";
+        for (size_t i = 0; i < names.size(); ++i) {
+            char line[96];
+            std::snprintf(line, sizeof(line), "  %-14s %9s / %s\n", names[i].c_str(),
+                          formatDuration(histograms[i].percentile(0.50)).c_str(),
+                          formatDuration(histograms[i].percentile(0.99)).c_str());
+            text += line;
+        }
+        return text;
+    }
+
+    void writeJson(std::ostream& out) const {
+        out << "{\n  \"phases\": [\n";
+        for (size_t i = 0; i < names.size(); ++i) {
+            const DurationHistogram& h = histograms[i];
+            out << "    {\"name\": \"" << names[i] << "\", \"count\": " << h.count()
+                << ", \"p50_ns\": " << h.percentile(0.50) << ", \"p99_ns\": " << h.percentile(0.99)
+                << ", \"max_ns\": " << h.max() << "}" << (i + 1 < names.size() ? "," : "") << "\n";
+        }
+        out << "  ]\n}\n";
+    }
+
+private:
+    std::vector<std::string> names;
+    std::vector<DurationHistogram> histograms;
+};
+
+// Write the per-phase timings of a finished run to a JSON file.
+inline void writeStats(const TickProfiler& profiler, const std::string& path) {
+    std::ofstream statsFile(path);
+    profiler.writeJson(statsFile);
+    std::cout << "Wrote tick timings to " << path << std::endl;
+}
+
+// Times the enclosing scope and records it under the given phase.
+class ScopedPhaseTimer {
+public:
+    ScopedPhaseTimer(TickProfiler& profiler, int phase)
+        : profiler(profiler), phase(phase), start(std::chrono::steady_clock::now()) {}
+
+    ~ScopedPhaseTimer() {
+        profiler.record(phase, std::chrono::steady_clock::now() - start);
+    }
+
+private:
+    TickProfiler& profiler;
+    int phase;
+    std::chrono::steady_clock::time_point start;
+};
+
+// Paces a loop to a fixed period by sleeping until absolute deadlines (start + n * period).
+// If a frame overruns by a whole period or more, the missed deadlines are skipped
+// instead of running several frames back to back to catch up.
+class FramePacer {
+public:
+    explicit FramePacer(std::chrono::nanoseconds period)
+        : period(period), deadline(std::chrono::steady_clock::now() + period), missed(0) {}
+
+    void wait() {
+        std::this_thread::sleep_until(deadline);
+        deadline += period;
+
+        auto now = std::chrono::steady_clock::now();
+        if (now >= deadline) {
+            auto behind = (now - deadline) / period + 1;
+            missed += static_cast<uint64_t>(behind);
+            deadline += behind * period;
+        }
+    }
+
+    uint64_t missedDeadlines() const { return missed; }
+
+private:
+    std::chrono::nanoseconds period;
+    std::chrono::steady_clock::time_point deadline;
+    uint64_t missed;
+};
+
+#endif